@@ -23,7 +23,24 @@ SOURCES += main.cpp\
     frog.cpp \
     player.cpp \
     myplayer.cpp \
-    matrix.cpp
+    matrix.cpp \
+    planner.cpp \
+    scene.cpp \
+    lightindex.cpp \
+    arena.cpp \
+    log.cpp \
+    frameexporter.cpp \
+    metrics.cpp \
+    strategyparams.cpp \
+    tuner.cpp \
+    boardkernel.cpp \
+    densitymap.cpp \
+    taskpool.cpp \
+    allocprofile.cpp \
+    bench.cpp \
+    vecenv.cpp \
+    densityfield.cpp \
+    stepdelta.cpp
 
 HEADERS  += \
     glwidget.h \
@@ -36,7 +53,24 @@ HEADERS  += \
     frog.h \
     player.h \
     myplayer.h \
-    matrix.h
+    matrix.h \
+    planner.h \
+    scene.h \
+    lightindex.h \
+    arena.h \
+    log.h \
+    frameexporter.h \
+    metrics.h \
+    strategyparams.h \
+    tuner.h \
+    boardkernel.h \
+    densitymap.h \
+    taskpool.h \
+    allocprofile.h \
+    bench.h \
+    vecenv.h \
+    densityfield.h \
+    stepdelta.h
 
 FORMS    += \
     mainwindow.ui
@@ -48,6 +82,11 @@ DISTFILES += \
 
 LIBS += -larmadillo
 
+# qmake CONFIG+=alloc_profile counts every heap allocation per phase (see allocprofile.h and --alloc-profile)
+alloc_profile {
+    DEFINES += ALLOC_PROFILE
+}
+
 macx {
  QMAKE_CXXFLAGS += -std=c++11
 
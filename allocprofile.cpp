@@ -0,0 +1,281 @@
+#include "allocprofile.h"
+
+#ifdef ALLOC_PROFILE
+
+#include <atomic>
+#include <errno.h>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Nothing in here may allocate: it would recurse into the counters.
+
+static const int MAX_PHASES = 64;
+
+struct PhaseCounters {
+    std::atomic<long long> allocations;
+    std::atomic<long long> bytes;
+    std::atomic<long long> live;
+    std::atomic<long long> peakLive;
+};
+
+struct Phase {
+    const char* name;
+    PhaseCounters total;
+    PhaseCounters round; // live is unused; peakLive starts at the phase's live bytes when the round begins
+};
+
+static Phase phases[MAX_PHASES]; // zero-initialized, so allocations before main are counted too
+static std::atomic<int> numPhases(1); // phase 0 is "other"
+static std::mutex phasesMutex;
+static thread_local int currentPhase = 0;
+
+static const char* phaseName(int phase) {
+    return phase == 0 ? "other" : phases[phase].name;
+}
+
+static FILE* roundLog = 0;
+static int currentRound = 0;
+
+// every block is preceded by a header that remembers where the underlying block starts, the size asked
+// for and the phase that allocated it
+struct alignas(16) BlockHeader {
+    void* base;
+    size_t size;
+    int phase;
+};
+
+// glibc's own allocator, which the replacements below allocate from
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+
+static void raiseTo(std::atomic<long long>& peak, long long value) {
+    long long seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+static void* allocate(size_t size, size_t alignment = alignof(BlockHeader)) {
+    // the header sits right before the block, so the block starts a whole number of alignments after the base
+    size_t offset = alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+    void* base = alignment > alignof(BlockHeader) ? __libc_memalign(alignment, offset + size) : __libc_malloc(offset + size);
+    if (!base) {
+        return 0;
+    }
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(base) + offset) - 1;
+    int p = currentPhase;
+    header->base = base;
+    header->size = size;
+    header->phase = p;
+    Phase& phase = phases[p];
+    phase.total.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.total.bytes.fetch_add(size, std::memory_order_relaxed);
+    long long live = phase.total.live.fetch_add(size, std::memory_order_relaxed) + size;
+    raiseTo(phase.total.peakLive, live);
+    phase.round.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.round.bytes.fetch_add(size, std::memory_order_relaxed);
+    raiseTo(phase.round.peakLive, live);
+    return header + 1;
+}
+
+static BlockHeader* headerOf(void* pointer) {
+    return static_cast<BlockHeader*>(pointer) - 1;
+}
+
+static void release(void* pointer) {
+    if (!pointer) {
+        return;
+    }
+    BlockHeader* header = headerOf(pointer);
+    // live bytes go back to the phase that allocated them, wherever they are freed
+    phases[header->phase].total.live.fetch_sub(header->size, std::memory_order_relaxed);
+    __libc_free(header->base);
+}
+
+// The C allocator is replaced rather than operator new, because Qt's containers and Armadillo allocate
+// with malloc and realloc directly; operator new goes through malloc too. glibc requires the whole family
+// to be replaced together, so that every block it hands to free() came from here.
+extern "C" {
+
+void* malloc(size_t size) {
+    return allocate(size);
+}
+
+void free(void* pointer) {
+    release(pointer);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (size != 0 && count > (size_t) -1 / size) {
+        return 0;
+    }
+    void* result = allocate(count * size);
+    if (result) {
+        memset(result, 0, count * size);
+    }
+    return result;
+}
+
+void* realloc(void* pointer, size_t size) {
+    if (!pointer) {
+        return allocate(size);
+    }
+    if (size == 0) {
+        release(pointer);
+        return 0;
+    }
+    // a reallocation counts as a new allocation of the phase that asks for it
+    void* result = allocate(size);
+    if (result) {
+        size_t old = headerOf(pointer)->size;
+        memcpy(result, pointer, old < size ? old : size);
+        release(pointer);
+    }
+    return result;
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* pointer = allocate(size, alignment);
+    if (!pointer) {
+        return ENOMEM;
+    }
+    *result = pointer;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return allocate(size, alignment);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    return allocate(size, alignment);
+}
+
+void* valloc(size_t size) {
+    return allocate(size, sysconf(_SC_PAGESIZE));
+}
+
+void* pvalloc(size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    return allocate((size + page - 1) / page * page, page);
+}
+
+size_t malloc_usable_size(void* pointer) {
+    return pointer ? headerOf(pointer)->size : 0;
+}
+
+}
+
+bool AllocProfiler::compiledIn() {
+    return true;
+}
+
+int AllocProfiler::phase(const char* name) {
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    for (int p = 1; p < numPhases; p++) {
+        if (strcmp(phases[p].name, name) == 0) {
+            return p;
+        }
+    }
+    if (numPhases == MAX_PHASES) {
+        return 0;
+    }
+    phases[numPhases].name = name;
+    return numPhases++;
+}
+
+int AllocProfiler::activePhase() {
+    return currentPhase;
+}
+
+int AllocProfiler::enterPhase(int phase) {
+    int previous = currentPhase;
+    currentPhase = phase;
+    return previous;
+}
+
+void AllocProfiler::leavePhase(int previous) {
+    currentPhase = previous;
+}
+
+bool AllocProfiler::open(const QString& path) {
+    close();
+    roundLog = fopen(qPrintable(path), "w");
+    if (!roundLog) {
+        return false;
+    }
+    fprintf(roundLog, "round,phase,allocations,bytes,peak_live_bytes\n");
+    return true;
+}
+
+void AllocProfiler::close() {
+    if (roundLog) {
+        beginRound(currentRound + 1); // writes out the last round
+        fclose(roundLog);
+        roundLog = 0;
+    }
+}
+
+void AllocProfiler::beginRound(int round) {
+    for (int p = 0; p < numPhases; p++) {
+        Phase& phase = phases[p];
+        long long allocations = phase.round.allocations.exchange(0, std::memory_order_relaxed);
+        long long bytes = phase.round.bytes.exchange(0, std::memory_order_relaxed);
+        long long peak = phase.round.peakLive.exchange(phase.total.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (roundLog && allocations > 0) {
+            fprintf(roundLog, "%d,%s,%lld,%lld,%lld\n", currentRound, phaseName(p), allocations, bytes, peak);
+        }
+    }
+    currentRound = round;
+}
+
+void AllocProfiler::report(FILE* out) {
+    fprintf(out, "%-24s %14s %16s %16s\n", "phase", "allocations", "bytes", "peak live bytes");
+    for (int p = 0; p < numPhases; p++) {
+        fprintf(out, "%-24s %14lld %16lld %16lld\n", phaseName(p), phases[p].total.allocations.load(),
+                phases[p].total.bytes.load(), phases[p].total.peakLive.load());
+    }
+}
+
+#else
+
+bool AllocProfiler::compiledIn() {
+    return false;
+}
+
+bool AllocProfiler::open(const QString&) {
+    return false;
+}
+
+void AllocProfiler::close() {
+}
+
+void AllocProfiler::beginRound(int) {
+}
+
+void AllocProfiler::report(FILE*) {
+}
+
+int AllocProfiler::phase(const char*) {
+    return 0;
+}
+
+int AllocProfiler::activePhase() {
+    return 0;
+}
+
+int AllocProfiler::enterPhase(int) {
+    return 0;
+}
+
+void AllocProfiler::leavePhase(int) {
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef ALLOCPROFILE_H
+#define ALLOCPROFILE_H
+
+#include <stdio.h>
+#include <QString>
+
+// Counts heap allocations per phase of the simulation. Built with qmake CONFIG+=alloc_profile (which defines
+// ALLOC_PROFILE), malloc and the rest of the C allocator (which operator new, Qt's containers and Armadillo
+// all end up in) are replaced by versions that charge every allocation to the innermost ALLOC_SCOPE active
+// on the calling thread ("other" outside of any scope). Tasks on the TaskPool count towards the scope that
+// started them. Without the flag the scopes compile to nothing and the allocator is untouched (glibc only).
+//
+// Usage: ALLOC_SCOPE("moveMosquitoes"); at the top of a block. The name must be a string literal.
+// Board::step starts a new round for the per-round counts, so those are only meaningful with one Board.
+class AllocProfiler
+{
+public:
+    static bool compiledIn();
+
+    // writes one CSV row per phase and round (round,phase,allocations,bytes,peak_live_bytes) to path
+    static bool open(const QString& path);
+    static void close();
+    static void beginRound(int round);
+
+    // allocations, bytes and peak live bytes of every phase since the start
+    static void report(FILE* out);
+
+    static int phase(const char* name); // registers a phase (once per scope, see ALLOC_SCOPE)
+    static int activePhase(); // on the calling thread
+    static int enterPhase(int phase); // returns the phase that was active
+    static void leavePhase(int previous);
+};
+
+class AllocScope
+{
+public:
+    AllocScope(int phase) { this->previous = AllocProfiler::enterPhase(phase); }
+    ~AllocScope() { AllocProfiler::leavePhase(this->previous); }
+
+private:
+    int previous;
+};
+
+#define ALLOC_CONCAT2(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT2(a, b)
+
+#ifdef ALLOC_PROFILE
+#define ALLOC_SCOPE(name) \
+    static const int ALLOC_CONCAT(allocPhase, __LINE__) = AllocProfiler::phase(name); \
+    AllocScope ALLOC_CONCAT(allocScope, __LINE__)(ALLOC_CONCAT(allocPhase, __LINE__))
+#define ALLOC_ROUND(round) AllocProfiler::beginRound(round)
+#else
+#define ALLOC_SCOPE(name)
+#define ALLOC_ROUND(round)
+#endif
+
+#endif // ALLOCPROFILE_H
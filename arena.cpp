@@ -0,0 +1,65 @@
+#include "arena.h"
+#include <stdlib.h>
+
+Arena::Arena(size_t blockSize)
+{
+    this->blockSize = blockSize;
+    this->currentBlock = 0;
+    this->offset = 0;
+    this->finalizers = 0;
+    this->systemAllocations = 0;
+}
+
+Arena::~Arena()
+{
+    rewind();
+    for (size_t b = 0; b < this->blocks.size(); b++) {
+        free(this->blocks[b].memory);
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    while (this->currentBlock < this->blocks.size()) {
+        Block& block = this->blocks[this->currentBlock];
+        size_t start = (this->offset + alignment - 1) / alignment * alignment;
+        if (start + size <= block.size) {
+            this->offset = start + size;
+            return block.memory + start;
+        }
+        // doesn't fit: move on to the next block (kept from an earlier game, if there is one)
+        this->currentBlock++;
+        this->offset = 0;
+    }
+
+    // malloc'd memory is aligned for any fundamental type, so a fresh block never needs padding
+    Block block;
+    block.size = size > this->blockSize ? size : this->blockSize;
+    block.memory = static_cast<char*>(malloc(block.size));
+    if (!block.memory) {
+        throw std::bad_alloc();
+    }
+    this->systemAllocations++;
+    this->blocks.push_back(block);
+    this->currentBlock = this->blocks.size() - 1;
+    this->offset = size;
+    return block.memory;
+}
+
+void Arena::addFinalizer(void (*destroy)(void*, int), void* objects, int count) {
+    Finalizer* finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+    finalizer->destroy = destroy;
+    finalizer->objects = objects;
+    finalizer->count = count;
+    finalizer->next = this->finalizers;
+    this->finalizers = finalizer;
+}
+
+void Arena::rewind() {
+    // destroy in reverse order of construction
+    for (Finalizer* f = this->finalizers; f; f = f->next) {
+        f->destroy(f->objects, f->count);
+    }
+    this->finalizers = 0;
+    this->currentBlock = 0;
+    this->offset = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+
+// Bump allocator that owns the objects of one game (mosquitoes, lights, ...).
+// rewind() throws everything away at once and keeps the memory blocks for the next game, so once the
+// arena has grown to the size of a game, the objects of new games don't touch the system allocator.
+// What those objects allocate themselves (a Light's trail, say) and the Player's working data still do.
+class Arena
+{
+public:
+    Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    void* allocate(size_t size, size_t alignment);
+    void rewind(); // destroys every object made since the last rewind; objects with trivial destructors cost nothing
+
+    // constructs count default-constructed T's next to each other
+    template <typename T>
+    T* makeArray(int count) {
+        T* objects = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        for (int i = 0; i < count; i++) {
+            new (&objects[i]) T();
+        }
+        if (!std::is_trivially_destructible<T>::value) {
+            addFinalizer(&destroyArray<T>, objects, count);
+        }
+        return objects;
+    }
+
+    template <typename T>
+    T* make() {
+        return makeArray<T>(1);
+    }
+
+    int systemAllocations; // number of blocks requested from the system allocator so far
+
+private:
+    struct Block {
+        char* memory;
+        size_t size;
+    };
+    // objects that need their destructor run on rewind; the list itself lives in the arena
+    struct Finalizer {
+        void (*destroy)(void* objects, int count);
+        void* objects;
+        int count;
+        Finalizer* next;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t currentBlock;
+    size_t offset;
+    Finalizer* finalizers;
+
+    void addFinalizer(void (*destroy)(void*, int), void* objects, int count);
+
+    template <typename T>
+    static void destroyArray(void* objects, int count) {
+        for (int i = 0; i < count; i++) {
+            static_cast<T*>(objects)[i].~T();
+        }
+    }
+};
+
+#endif // ARENA_H
@@ -0,0 +1,114 @@
+#include "bench.h"
+#include "board.h"
+#include <QElapsedTimer>
+#include <string.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Leaves the lights where they start, so the benchmark measures the Board and not a strategy
+class IdlePlayer : public Player
+{
+public:
+    QVector<glm::vec2> updateLights(QVector<QVector<int> >* board) {
+        return QVector<glm::vec2>(this->lights.size(), glm::vec2(0.0f, 0.0f));
+    }
+
+    void initializeLights(QVector<QVector<int> >* board) {
+        for (int i = 0; i < this->lights.size(); i++) {
+            this->lights.at(i)->setInitialPosition(100.0f + 100.0f * i, 250.0f);
+        }
+    }
+
+    glm::vec2 initializeFrog(QVector<QVector<int> >* board) {
+        return glm::vec2(250.0f, 250.0f);
+    }
+};
+
+// Hardware cache-miss counter for the calling thread; reads -1 where it isn't available
+class CacheMissCounter
+{
+public:
+    CacheMissCounter() {
+        this->fd = -1;
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        this->fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (this->fd >= 0) {
+            close(this->fd);
+        }
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+        if (this->fd >= 0) {
+            ioctl(this->fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(this->fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long stop() {
+        long long count = -1;
+#ifdef __linux__
+        if (this->fd >= 0) {
+            ioctl(this->fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(this->fd, &count, sizeof(count)) != sizeof(count)) {
+                count = -1;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+int runSortBenchmark(int numMosquitoes, int rounds, FILE* out) {
+    fprintf(out, "%d mosquitoes, %d rounds\n", numMosquitoes, rounds);
+    fprintf(out, "%-12s %16s %22s\n", "order", "ms per round", "cache misses per round");
+    for (int sorted = 0; sorted < 2; sorted++) {
+        Board board(new IdlePlayer());
+        board.numMosquitoes = numMosquitoes;
+        board.captureTarget = numMosquitoes;
+        board.seed(1);
+        board.sortThreshold = sorted ? 0.25f : 2.0f;
+        board.initialize();
+        if (sorted) {
+            board.sortMosquitoes();
+        }
+
+        CacheMissCounter misses;
+        QElapsedTimer timer;
+        timer.start();
+        misses.start();
+        for (int r = 0; r < rounds; r++) {
+            board.step();
+        }
+        long long missCount = misses.stop();
+        double ms = timer.nsecsElapsed() / 1e6 / rounds;
+        if (missCount >= 0) {
+            fprintf(out, "%-12s %16.2f %22lld\n", sorted ? "z-order" : "creation", ms, missCount / rounds);
+        } else {
+            fprintf(out, "%-12s %16.2f %22s\n", sorted ? "z-order" : "creation", ms, "n/a");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+// Steps a board of numMosquitoes mosquitoes for rounds rounds twice, once keeping the mosquitoes in Z-order
+// (Board::sortMosquitoes) and once leaving them in creation order, and reports the time per round and,
+// where the kernel lets us read the hardware counters, the cache misses per round.
+int runSortBenchmark(int numMosquitoes, int rounds, FILE* out);
+
+#endif // BENCH_H
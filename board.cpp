@@ -1,57 +1,230 @@
 #include <board.h>
 #include <QDebug>
+#include "log.h"
+#include "boardkernel.h"
+#include "allocprofile.h"
+#include <QElapsedTimer>
+#include <algorithm>
 
-QList<Wall*> Board::walls;
-int Board::boardSize = 500.0f;
+Board::Board() : Board(new MyPlayer())
+{
+}
 
-Board::Board()
+Board::Board(Player* player)
 {
     this->numLights = 4;
     this->numMosquitoes = 500;
     this->numWalls = 1;
+    this->boardSize = 500;
+    this->scene = 0;
+    this->random.seed(std::random_device()());
+    this->pipelined = false;
+    this->metrics = 0;
+    this->playerTime = 0;
+    this->stepTime = 0;
+    this->pendingPlayerTime = 0;
+    this->mosquitoKernel = 0;
+    this->sortInterval = 0;
+    this->sortThreshold = 2.0f;
+    this->mosquitoDisorder = 0.0f;
+    this->observing = true;
+    this->hybrid = false;
+    this->hybridMargin = 10.0f;
+    this->maxSkip = 0;
     this->frog = new Frog();
     this->mosquitoesCaught = 0;
     this->mosquitoesEaten = 0;
     //initialize Player and pass along lights & walls
-    this->player = new MyPlayer();
-    this->player->lights = this->lights;
-    this->player->walls = this->walls;
+    this->player = player;
+    if (this->player) {
+        this->player->lights = this->lights;
+        this->player->walls = this->walls;
+    }
 
     this->currRound = 0;
     this->maxRounds = 5000;
     this->captureTarget = (int) this->numMosquitoes;// * 0.50f; // initially capture 100%
 }
 
+Board::~Board() {
+    // a destructor can't throw, so an error of the last decision is dropped
+    this->decision.wait();
+    // the mosquitoes and lights belong to the arena
+    delete this->frog;
+    delete this->player;
+}
+
+void Board::seed(unsigned int seed) {
+    this->random.seed(seed);
+}
+
+Board* Board::fork(bool withTrails) {
+    Board* result = new Board(0);
+    result->copyFrom(this, withTrails);
+    return result;
+}
+
+void Board::copyFrom(Board* source, bool withTrails) {
+    this->mosquitoes.erase(this->mosquitoes.begin(), this->mosquitoes.end());
+    this->spareMosquitoes.erase(this->spareMosquitoes.begin(), this->spareMosquitoes.end());
+    this->lights.erase(this->lights.begin(), this->lights.end());
+    this->arena.rewind();
+
+    this->boardSize = source->boardSize;
+    this->walls = source->walls;
+    this->scene = source->scene;
+    // copies continue the source's random sequence, so copies of the same Board see the same mosquito moves
+    this->random = source->random;
+    this->numMosquitoes = source->numMosquitoes;
+    this->numLights = source->numLights;
+    this->numWalls = source->numWalls;
+    this->mosquitoesEaten = source->mosquitoesEaten;
+    this->mosquitoesCaught = source->mosquitoesCaught;
+    this->currRound = source->currRound;
+    this->frog->position = source->frog->position;
+    this->frog->radius = source->frog->radius;
+    this->hybrid = source->hybrid;
+    this->hybridMargin = source->hybridMargin;
+    this->field = source->field;
+    this->maxSkip = source->maxSkip;
+    this->nextDelta.clear();
+
+    Mosquito* mosquitoes = this->arena.makeArray<Mosquito>(source->mosquitoes.length());
+    for (int i = 0; i < source->mosquitoes.length(); i++) {
+        mosquitoes[i] = *source->mosquitoes.at(i);
+        this->mosquitoes.append(&mosquitoes[i]);
+    }
+    Light* lights = this->arena.makeArray<Light>(source->lights.length());
+    for (int j = 0; j < source->lights.length(); j++) {
+        // the trail is only copied if asked for (the lists are shared until one of them changes)
+        Light* l = &lights[j];
+        glm::vec2 position = source->lights.at(j)->getPosition();
+        l->radius = source->lights.at(j)->radius;
+        l->board = this;
+        l->setInitialPosition(position.x, position.y);
+        if (withTrails) {
+            l->trail = source->lights.at(j)->trail;
+            l->trailColor = source->lights.at(j)->trailColor;
+        }
+        this->lights.append(l);
+    }
+    if (withTrails) {
+        // copies that are drawn get the last observation too, for the heatmap (shared until either changes)
+        this->occupancy = source->occupancy;
+    }
+    updateMosquitoKernel();
+}
+
+Board* Board::fromObservation(QVector<QVector<int> >* board, QList<Light*> lights, glm::vec2 frogPosition,
+                              QList<Wall*> walls, Scene* scene, unsigned int seed) {
+    Board* result = new Board(0);
+    result->loadObservation(board, lights, frogPosition, walls, scene, seed);
+    return result;
+}
+
+void Board::loadObservation(QVector<QVector<int> >* board, QList<Light*> lights, glm::vec2 frogPosition,
+                            QList<Wall*> walls, Scene* scene, unsigned int seed) {
+    this->currRound = 0;
+    this->mosquitoesEaten = 0;
+    this->mosquitoesCaught = 0;
+    this->mosquitoes.erase(this->mosquitoes.begin(), this->mosquitoes.end());
+    this->spareMosquitoes.erase(this->spareMosquitoes.begin(), this->spareMosquitoes.end());
+    this->lights.erase(this->lights.begin(), this->lights.end());
+    this->arena.rewind();
+
+    this->frog->position = frogPosition;
+    this->walls = walls;
+    this->numWalls = walls.length();
+    this->scene = scene;
+    this->random.seed(seed);
+    this->nextDelta.clear();
+
+    int count = 0;
+    for (int x = 0; x < board->size(); x++) {
+        for (int y = 0; y < board->at(x).size(); y++) {
+            count += board->at(x).at(y);
+        }
+    }
+    // every mosquito is placed in the middle of the cell it was observed in
+    Mosquito* mosquitoes = this->arena.makeArray<Mosquito>(count);
+    for (int x = 0; x < board->size(); x++) {
+        for (int y = 0; y < board->at(x).size(); y++) {
+            for (int n = 0; n < board->at(x).at(y); n++) {
+                Mosquito* m = &mosquitoes[this->mosquitoes.length()];
+                m->position = glm::vec2(glm::min(x + 0.5f, (float) this->boardSize), glm::min(y + 0.5f, (float) this->boardSize));
+                this->mosquitoes.append(m);
+            }
+        }
+    }
+    this->numMosquitoes = this->mosquitoes.length();
+
+    Light* boardLights = this->arena.makeArray<Light>(lights.length());
+    for (int j = 0; j < lights.length(); j++) {
+        Light* l = &boardLights[j];
+        glm::vec2 position = lights.at(j)->getPosition();
+        l->radius = lights.at(j)->radius;
+        l->board = this;
+        l->setInitialPosition(position.x, position.y);
+        this->lights.append(l);
+    }
+    this->numLights = this->lights.length();
+    updateMosquitoKernel();
+}
+
 void Board::initialize() {
+    ALLOC_SCOPE("initialize");
+    waitForDecision();
     this->currRound = 0;
     this->mosquitoesEaten = 0;
     this->mosquitoesCaught = 0;
-    this->mosquitoes.clear();
-    this->lights.clear();
-//    this->walls.clear();
+    // drop the Player's reference first, so the lists aren't shared and erasing them keeps their storage
     this->player->lights.clear();
-//    this->player->walls.clear();
+    this->mosquitoes.erase(this->mosquitoes.begin(), this->mosquitoes.end());
+    this->spareMosquitoes.erase(this->spareMosquitoes.begin(), this->spareMosquitoes.end());
+    // the first observation of a game is published as changes from an empty board
+    this->observedOccupancy.fill(0);
+    this->nextDelta.clear();
+    this->lights.erase(this->lights.begin(), this->lights.end());
+    // everything from the last game goes at once; the arena keeps its memory for this one
+    this->arena.rewind();
 
-
-    for (int i = 0; i < this->numMosquitoes; i++) {
-        float random = static_cast <float> (rand()) / static_cast <float> (RAND_MAX/this->boardSize);
-        float random2 = static_cast <float> (rand()) / static_cast <float> (RAND_MAX/this->boardSize);
-        Mosquito* m = new Mosquito();
-        m->position = glm::vec2(random, random2);
-        this->mosquitoes.append(m);
+    std::uniform_real_distribution<float> coordinate(0.0f, this->boardSize);
+    if (this->hybrid) {
+        // every mosquito starts in the field; the first moveMosquitoes takes out the ones near the lights
+        this->field.reset(this);
+        for (int i = 0; i < this->numMosquitoes; i++) {
+            float random = coordinate(this->random);
+            float random2 = coordinate(this->random);
+            this->field.add(glm::vec2(random, random2));
+        }
+    } else {
+        Mosquito* mosquitoes = this->arena.makeArray<Mosquito>(this->numMosquitoes);
+        for (int i = 0; i < this->numMosquitoes; i++) {
+            float random = coordinate(this->random);
+            float random2 = coordinate(this->random);
+            Mosquito* m = &mosquitoes[i];
+            m->position = glm::vec2(random, random2);
+            this->mosquitoes.append(m);
+        }
     }
 
+    Light* lights = this->arena.makeArray<Light>(this->numLights);
     for (int j = 0; j < this->numLights; j++) {
-        float random = static_cast <float> (rand()) / static_cast <float> (RAND_MAX/this->boardSize);
-        float random2 = static_cast <float> (rand()) / static_cast <float> (RAND_MAX/this->boardSize);
-        Light* l = new Light();
+        float random = coordinate(this->random);
+        float random2 = coordinate(this->random);
+        Light* l = &lights[j];
+        l->board = this;
         l->moveTo(random, random2);
         this->lights.append(l);
     }
     this->player->lights = this->lights;
+    // the Player may have replaced its walls with derived ones during the last game
+    this->player->walls = this->walls;
+    updateMosquitoKernel();
     generateBoardForPlayer();
     this->frog->position = this->player->initializeFrog(&this->playerBoard);
     this->player->initializeLights(&this->playerBoard);
+    syncPlayer();
 }
 
 bool checkWithinRadius(glm::vec2 objPos, glm::vec2 circlePos, int radius) {
@@ -65,104 +238,413 @@ bool checkWithinRadius(glm::vec2 objPos, glm::vec2 circlePos, int radius) {
     }
 }
 
-void Board::generateBoardForPlayer() {
-    QVector<QVector<int> > result;
-    result.resize(this->boardSize+1);
+// mosquitoes in the same SORT_BLOCK x SORT_BLOCK block of cells share a sort key, so a mosquito only
+// falls out of order when it crosses into another block, not every time it moves to the next cell
+static const int SORT_BLOCK_SHIFT = 3;
+
+// interleaves the bits of x and y (16 bits each)
+static quint32 mortonCode(int x, int y) {
+    quint32 code[2] = {(quint32) glm::max(x, 0) & 0xffff, (quint32) glm::max(y, 0) & 0xffff};
+    for (int c = 0; c < 2; c++) {
+        code[c] = (code[c] | (code[c] << 8)) & 0x00ff00ff;
+        code[c] = (code[c] | (code[c] << 4)) & 0x0f0f0f0f;
+        code[c] = (code[c] | (code[c] << 2)) & 0x33333333;
+        code[c] = (code[c] | (code[c] << 1)) & 0x55555555;
+    }
+    return code[0] | (code[1] << 1);
+}
+
+static quint32 sortKey(glm::vec2 position) {
+    return mortonCode((int) glm::floor(position.x) >> SORT_BLOCK_SHIFT, (int) glm::floor(position.y) >> SORT_BLOCK_SHIFT);
+}
 
-    for (int v = 0; v < result.size(); v++) {
-        result[v].resize(this->boardSize+1);
+void Board::sortMosquitoes() {
+    int n = this->mosquitoes.length();
+    this->sortKeys.resize(n);
+    for (int i = 0; i < n; i++) {
+        this->sortKeys[i] = std::make_pair(sortKey(this->mosquitoes.at(i)->position), i);
     }
+    std::sort(this->sortKeys.begin(), this->sortKeys.end());
 
-    // initialize vector to 0s
-    for (int a = 0; a < result.size(); a++) {
-        for (int b = 0; b < result.at(a).size(); b++) {
-            result[a][b] = 0;
-            //qDebug() << "board[" << a << "][" << b << "] is " << result.at(a).at(b);
+    // the list keeps pointing at the same slots; the mosquitoes are moved between them
+    this->sortScratch.resize(n);
+    for (int i = 0; i < n; i++) {
+        this->sortScratch[i] = *this->mosquitoes.at(this->sortKeys[i].second);
+    }
+    for (int i = 0; i < n; i++) {
+        *this->mosquitoes.at(i) = this->sortScratch[i];
+    }
+    this->mosquitoDisorder = 0.0f;
+}
+
+void Board::generateBoardForPlayer() {
+    ALLOC_SCOPE("generateBoardForPlayer");
+    // the boards are reused from the last call, so they only allocate when the board size changes
+    QVector<QVector<int> >& result = this->playerBoard;
+    int size = this->boardSize+1;
+    if (result.size() != size) {
+        result.resize(size);
+    }
+    if (!this->observing) {
+        for (int x = 0; x < size; x++) {
+            if (result.at(x).size() != size) {
+                result[x].resize(size);
+            }
         }
+        this->nextDelta.clear();
+        return;
     }
+    // the mosquitoes are counted into the flat copy, which is then copied column by column into playerBoard
+    this->occupancy.fill(0, size * size);
+    int* counts = this->occupancy.data();
 
+    int outOfOrder = 0;
+    quint32 lastKey = 0;
     for (int i = 0; i < this->mosquitoes.length(); i++) {
         int xPos = (int) glm::floor(this->mosquitoes.at(i)->position.x);
         int yPos = (int) glm::floor(this->mosquitoes.at(i)->position.y);
 
         if (xPos <= this->boardSize && yPos <= this->boardSize && xPos >= 0 && yPos >= 0) {
-            result[xPos][yPos]++;
+            counts[xPos * size + yPos]++;
             //qDebug() << xPos << ", " << yPos << ": " << result[xPos][yPos];
         }
+        quint32 key = mortonCode(xPos >> SORT_BLOCK_SHIFT, yPos >> SORT_BLOCK_SHIFT);
+        outOfOrder += key < lastKey;
+        lastKey = key;
+    }
+    this->mosquitoDisorder = this->mosquitoes.length() > 1 ? outOfOrder / (float) (this->mosquitoes.length() - 1) : 0.0f;
+    if (this->hybrid && this->field.size() == size) {
+        // the Player sees the field as whole mosquitoes, so the counts still add up to every free mosquito
+        this->field.addCounts(counts);
+    }
+
+    // publish what changed since the last observation; the two deltas swap, so neither gives up its storage
+    if (this->observedOccupancy.size() != size * size) {
+        this->observedOccupancy.fill(0, size * size);
+    }
+    int* observed = this->observedOccupancy.data();
+    for (int c = 0; c < size * size; c++) {
+        if (counts[c] != observed[c]) {
+            StepDelta::Cell cell = {c / size, c % size, observed[c], counts[c]};
+            this->nextDelta.cells.append(cell);
+            observed[c] = counts[c];
+        }
     }
+    this->nextDelta.round = this->currRound;
+    std::swap(this->delta, this->nextDelta);
+    this->nextDelta.clear();
 
-    this->playerBoard = result;
+    for (int x = 0; x < size; x++) {
+        if (result.at(x).size() != size) {
+            result[x].resize(size);
+        }
+        std::copy(counts + x * size, counts + (x + 1) * size, result[x].begin());
+    }
+    this->density.rebuild(result);
+}
+
+bool Board::recordsDelta() {
+    // forks, planner copies and Boards rebuilt from an observation never publish a delta
+    return this->player != 0 && this->observing;
 }
 
 void Board::step() {
-    this->currRound++;
+    QElapsedTimer timer;
+    timer.start();
 
     if (this->lights.size() != this->player->lights.size()) {
-        qDebug() << "Num of player lights not equal to num of board lights";
+        LOG(LOG_WARNING) << "Num of player lights not equal to num of board lights";
+        this->currRound++; // the round still counts, so the game ends
         return;
     }
 
+    if (this->pipelined) {
+        stepPipelined();
+    } else {
+        stepSequential();
+    }
+
+    this->stepTime = timer.nsecsElapsed();
+    if (this->metrics) {
+        this->metrics->record(this);
+    }
+}
+
+// Called once the pending decision (if any) has finished, so nothing else looks at the mosquitoes
+void Board::startRound() {
+    this->currRound++;
+    ALLOC_ROUND(this->currRound);
+
+    // keep neighbouring mosquitoes next to each other in memory, so the grid and the walls are walked in order
+    if (this->mosquitoDisorder > this->sortThreshold ||
+            (this->sortInterval > 0 && this->currRound % this->sortInterval == 0)) {
+        sortMosquitoes();
+    }
+}
+
+void Board::stepSequential() {
+    startRound();
+
     // Ask the player where the lights should move
     generateBoardForPlayer(); //update playerboard
-    QList<glm::vec2> lightPositionsCheck;
-    for (int l1 = 0; l1 < this->lights.length(); l1++) {
-        lightPositionsCheck.append(this->lights.at(l1)->getPosition());
-    }
-    this->player->updateLights(&this->playerBoard);
-
-    for (int l2 = 0; l2 < this->lights.length(); l2++) {
-//        qDebug() << this->lights.at(l2)->position.x << this->lights.at(l2)->position.y;
-//        qDebug() << lightPositionsCheck.at(l2).x << lightPositionsCheck.at(l2).y;
-        if (glm::length(this->lights.at(l2)->getPosition() - lightPositionsCheck.at(l2)) > 3.0f) {
-            qDebug() << "Detected that light" << l2 << "has been moved more than once in one step. Resetting to previous position.";
-            // if lights have been moved more than once by the player in one step, set them to their previous position
-            while (this->lights.at(l2)->getPosition().x - lightPositionsCheck.at(l2).x > 0 ||
-                   this->lights.at(l2)->getPosition().y - lightPositionsCheck.at(l2).y > 0) {
-                this->lights.at(l2)->returnToPreviousPosition();
-            }
-        }
+    QElapsedTimer playerTimer;
+    playerTimer.start();
+    QVector<glm::vec2> moves;
+    {
+        ALLOC_SCOPE("updateLights");
+        moves = this->player->updateLights(&this->playerBoard);
     }
+    this->playerTime = playerTimer.nsecsElapsed();
+    moveLights(moves);
 
     // Move the mosquitoes
+    moveMosquitoes();
+}
+
+void Board::setPipelined(bool pipelined) {
+    waitForDecision();
+    this->pipelined = pipelined;
+    syncPlayer();
+}
+
+void Board::waitForDecision() {
+    this->decision.wait();
+    if (this->decisionError) {
+        std::exception_ptr error = this->decisionError;
+        this->decisionError = std::exception_ptr();
+        std::rethrow_exception(error);
+    }
+}
+
+// The Player reads the real lights in both modes: they only move in moveLights, which never runs during a decision
+void Board::syncPlayer() {
+    this->plannedMoves.clear();
+    if (!this->player) {
+        return;
+    }
+    this->player->lights = this->lights;
+    this->player->density = &this->density;
+    this->player->delta = &this->delta;
+    this->player->observationLag = this->pipelined ? 1 : 0;
+}
+
+void Board::stepPipelined() {
+    // the decision made from last round's observation moves the lights for this round
+    waitForDecision();
+    startRound();
+    this->playerTime = this->pendingPlayerTime;
+    if (!this->plannedMoves.isEmpty()) {
+        moveLights(this->plannedMoves);
+    }
+
+    // the Player looks at this round's board while the mosquitoes move; it can't change until the next step
+    generateBoardForPlayer();
+    // playerTime is only written by the decision and read after waitForDecision, so it lags one step here too
+    this->decision.run([this]() {
+        ALLOC_SCOPE("updateLights");
+        QElapsedTimer timer;
+        timer.start();
+        // an exception must not leave a pool task; the next waitForDecision throws it on the Board's thread
+        try {
+            this->plannedMoves = this->player->updateLights(&this->playerBoard);
+        } catch (...) {
+            this->plannedMoves.clear();
+            this->decisionError = std::current_exception();
+        }
+        this->pendingPlayerTime = timer.nsecsElapsed();
+    });
+
+    moveMosquitoes();
+}
+
+void Board::moveLights(const QVector<glm::vec2>& moves) {
+    ALLOC_SCOPE("moveLights");
+    int numLights = this->lights.length();
+    this->lightMoveAccepted.fill(false, numLights);
+    if (moves.size() != numLights) {
+        LOG(LOG_WARNING) << "Player returned " << moves.size() << " moves for " << numLights << " lights. No light moves this step.";
+        return;
+    }
+    // every move is checked against the positions before any light moves, then all the valid ones are made
+    for (int l = 0; l < numLights; l++) {
+        glm::vec2 from = this->lights.at(l)->getPosition();
+        this->lightMoveAccepted[l] = checkValidMove(from, from + moves.at(l));
+    }
+    bool record = recordsDelta();
+    for (int l = 0; l < numLights; l++) {
+        if (record) {
+            this->nextDelta.lightMoves.append(moves.at(l));
+            this->nextDelta.lightMoveAccepted.append(this->lightMoveAccepted.at(l));
+        }
+        if (this->lightMoveAccepted.at(l)) {
+            Light* light = this->lights.at(l);
+            light->placeAt(light->getPosition() + moves.at(l));
+            light->trail.append(light->getPosition());
+        }
+    }
+}
+
+void Board::updateMosquitoKernel() {
+    this->mosquitoKernel = selectMosquitoKernel(this->lights.length(), this->walls.length());
+}
+
+void Board::moveMosquitoes() {
+    ALLOC_SCOPE("moveMosquitoes");
+    if (this->hybrid) {
+        exchangeWithField();
+        this->field.diffuse();
+    }
+    // the kernels don't know about resting mosquitoes
+    if (this->mosquitoKernel && this->maxSkip <= 0) {
+        this->mosquitoKernel(this);
+        return;
+    }
+
+    // the lights don't move while the mosquitoes do, so they only need to be indexed once
+    this->lightIndex.rebuild(this->lights, this->boardSize);
+    bool record = recordsDelta();
+
     for (int i = 0; i < this->mosquitoes.length(); i++) {
+        if (this->mosquitoes.at(i)->wakeRound > this->currRound) {
+            continue;
+        }
+        bool wasCaught = this->mosquitoes.at(i)->isCaught;
+        bool wasEaten = this->mosquitoes.at(i)->isEaten;
         // see if it's about to be eaten by the frog
         if (checkWithinRadius(this->mosquitoes.at(i)->position, this->frog->position, this->frog->radius)) {
             this->mosquitoes.at(i)->isEaten = true;
         }
         else {
-            float closest = 500;
             glm::vec2 closestLightPos;
             this->mosquitoes.at(i)->isCaught = false; // this needs to be reset in case the light becomes obstructed
-            for (int k = 0; k < this->lights.length(); k++) {
-
-                // TODO: only consider lights that the mosquito can see and are not obstructed by a wall
-                bool canSeeLight = true;
-                for (int w = 0; w < this->walls.length(); w++) {
-                    if (this->walls[w]->isInvalidMove(this->mosquitoes.at(i)->position, this->lights.at(k)->getPosition())) {
-                        canSeeLight = false;
-                        break;
-                    }
-                }
 
-                if (canSeeLight) {
-                    if (checkWithinRadius(this->mosquitoes.at(i)->position, this->lights.at(k)->getPosition(), this->lights.at(k)->radius)) {
-                        this->mosquitoes.at(i)->isCaught = true;
-                        this->mosquitoesCaught++;
-                        closestLightPos = this->lights.at(k)->getPosition();
-                        break;
-                    } else {
-                        glm::vec2 currDist = this->lights.at(k)->getPosition() - this->mosquitoes.at(i)->position;
-                        if (glm::length(currDist) < closest) {
-                            closest = glm::length(currDist);
-                            closestLightPos = this->lights.at(k)->getPosition();
-                        }
-                    }
+            // only lights that the mosquito can see and that are not obstructed by a wall can catch it
+            int k = this->lightIndex.nearestVisible(this->mosquitoes.at(i)->position, this->lightIndex.maxRadius, true, this->walls, this->scene);
+            if (k >= 0) {
+                this->mosquitoes.at(i)->isCaught = true;
+                this->mosquitoesCaught++;
+                closestLightPos = this->lightIndex.position(k);
+            }
+            // mosquitoes that aren't caught move randomly, so there is no need to look up the closest light overall for them
+            else if (this->maxSkip > 0) {
+                int rounds = skipRounds(this->mosquitoes.at(i)->position);
+                if (rounds > 1) {
+                    // every step of the walk stays clear of the walls and edges, so none of them would be rejected
+                    this->mosquitoes.at(i)->move(this->mosquitoes.at(i)->calculateWalk(rounds, this->random));
+                    this->mosquitoes.at(i)->wakeRound = this->currRound + rounds;
+                    if (record) this->nextDelta.recordMosquito(this->mosquitoes.at(i), wasCaught, wasEaten);
+                    continue;
                 }
             }
 
-            glm::vec2 nextMove = this->mosquitoes.at(i)->calculateNextMove(closestLightPos);
+            glm::vec2 nextMove = this->mosquitoes.at(i)->calculateNextMove(closestLightPos, this->random);
             if (checkValidMove(this->mosquitoes.at(i)->position, nextMove)) this->mosquitoes.at(i)->move(nextMove);
         }
+        if (record) this->nextDelta.recordMosquito(this->mosquitoes.at(i), wasCaught, wasEaten);
+    }
+}
+
+// a light moves at most 3 units per round and a mosquito 2, so they get at most this much closer per round
+static const float CLOSING_SPEED = 5.0f;
+
+int Board::skipRounds(glm::vec2 position) {
+    // the walk must not get within reach of a light's radius before it ends
+    float lightGap = this->lightIndex.maxRadius + CLOSING_SPEED * this->maxSkip;
+    QList<Wall*> noWalls;
+    int k = this->lightIndex.nearestVisible(position, lightGap, false, noWalls, 0);
+    if (k >= 0) {
+        lightGap = glm::length(this->lightIndex.position(k) - position) - this->lightIndex.maxRadius;
+    }
+    float edgeGap = glm::min(glm::min(position.x, position.y), glm::min(this->boardSize - position.x, this->boardSize - position.y));
+    float frogGap = glm::length(position - this->frog->position) - this->frog->radius;
+    float gap = glm::min(glm::min(edgeGap, frogGap), wallClearance(position));
+    int rounds = glm::min((int) (lightGap / CLOSING_SPEED), (int) (gap / 2.0f));
+    return glm::min(rounds, this->maxSkip);
+}
+
+float Board::wallClearance(glm::vec2 position) {
+    if (this->scene && this->scene->isLoaded()) {
+        return this->scene->clearance(position);
+    }
+    float result = this->boardSize;
+    for (int w = 0; w < this->walls.length(); w++) {
+        glm::vec2 a = this->walls.at(w)->point1;
+        glm::vec2 b = this->walls.at(w)->point2;
+        float t = glm::dot(position - a, b - a) / glm::max(glm::dot(b - a, b - a), 1e-6f);
+        result = glm::min(result, glm::length(position - (a + glm::clamp(t, 0.0f, 1.0f) * (b - a))));
+    }
+    return result;
+}
+
+// new particles are taken from the arena in batches of this many
+static const int SPARE_MOSQUITO_BATCH = 256;
+
+Mosquito* Board::spareMosquito() {
+    if (this->spareMosquitoes.isEmpty()) {
+        Mosquito* batch = this->arena.makeArray<Mosquito>(SPARE_MOSQUITO_BATCH);
+        for (int i = 0; i < SPARE_MOSQUITO_BATCH; i++) {
+            this->spareMosquitoes.append(&batch[i]);
+        }
+    }
+    Mosquito* m = this->spareMosquitoes.takeLast();
+    *m = Mosquito();
+    return m;
+}
+
+void Board::exchangeWithField() {
+    this->lightIndex.rebuild(this->lights, this->boardSize);
+    float reach = this->lightIndex.maxRadius + this->hybridMargin;
+    // particles only go back once they are another margin further out, so they don't go back and forth every round
+    float release = reach + this->hybridMargin;
+    QList<Wall*> noWalls;
+    for (int i = this->mosquitoes.length() - 1; i >= 0; i--) {
+        Mosquito* m = this->mosquitoes.at(i);
+        if (m->isEaten || glm::length(m->position - this->frog->position) < this->frog->radius + release ||
+                this->lightIndex.nearestVisible(m->position, release, false, noWalls, 0) >= 0) {
+            continue;
+        }
+        this->field.add(m->position);
+        this->spareMosquitoes.append(m);
+        this->mosquitoes[i] = this->mosquitoes.last();
+        this->mosquitoes.removeLast();
+    }
+    if (this->field.isEmpty()) {
+        return;
+    }
+
+    // the cells around every light and the frog become particles, spread evenly over their cell
+    QVector<glm::vec2> centres;
+    QVector<float> radii;
+    for (int l = 0; l < this->lights.length(); l++) {
+        centres.append(this->lightIndex.position(l));
+        radii.append(reach);
+    }
+    centres.append(this->frog->position);
+    radii.append(this->frog->radius + reach);
+    std::uniform_real_distribution<float> offset(0.0f, 1.0f);
+    int last = this->field.size() - 1;
+    for (int c = 0; c < centres.size(); c++) {
+        glm::vec2 centre = centres.at(c);
+        float r = radii.at(c);
+        int x0 = glm::max(0, (int) glm::floor(centre.x - r));
+        int x1 = glm::min(last, (int) glm::floor(centre.x + r));
+        int y0 = glm::max(0, (int) glm::floor(centre.y - r));
+        int y1 = glm::min(last, (int) glm::floor(centre.y + r));
+        for (int x = x0; x <= x1; x++) {
+            for (int y = y0; y <= y1; y++) {
+                if (glm::length(glm::vec2(x + 0.5f, y + 0.5f) - centre) > r) {
+                    continue;
+                }
+                int n = this->field.take(x, y, this->random);
+                for (int k = 0; k < n; k++) {
+                    Mosquito* m = spareMosquito();
+                    float px = offset(this->random);
+                    float py = offset(this->random);
+                    m->position = glm::vec2(glm::min(x + px, (float) this->boardSize), glm::min(y + py, (float) this->boardSize));
+                    this->mosquitoes.append(m);
+                }
+            }
+        }
     }
 }
 
@@ -176,17 +658,66 @@ void Board::updateMosquitoesEaten() {
     this->mosquitoesEaten = result;
 }
 
+Mosquito* Board::mosquitoArray() {
+    if (this->mosquitoes.isEmpty()) {
+        return 0;
+    }
+    Mosquito* first = this->mosquitoes.first();
+    for (int i = 1; i < this->mosquitoes.length(); i++) {
+        if (this->mosquitoes.at(i) != first + i) {
+            return 0;
+        }
+    }
+    return first;
+}
+
+Light* Board::lightArray() {
+    if (this->lights.isEmpty()) {
+        return 0;
+    }
+    Light* first = this->lights.first();
+    for (int i = 1; i < this->lights.length(); i++) {
+        if (this->lights.at(i) != first + i) {
+            return 0;
+        }
+    }
+    return first;
+}
+
+bool Board::finished() {
+    updateMosquitoesEaten();
+    return this->mosquitoesEaten >= this->captureTarget || this->currRound >= this->maxRounds;
+}
+
+
+void Board::setScene(Scene* scene) {
+    this->scene = scene;
+    this->walls = scene->walls();
+    this->numWalls = this->walls.length();
+    updateMosquitoKernel();
+    if (this->player) {
+        this->player->walls = scene->walls();
+        this->player->scene = scene;
+    }
+}
+
+bool Board::wallBetween(glm::vec2 start, glm::vec2 end) {
+    if (this->scene && this->scene->isLoaded()) {
+        return this->scene->segmentHitsWall(start, end);
+    }
+    for (int w = 0; w < this->walls.length(); w++) {
+        if (this->walls.at(w)->isInvalidMove(start, end)) {
+            return true;
+        }
+    }
+    return false;
+}
 
 bool Board::checkValidMove(glm::vec2 oldPos, glm::vec2 newPos) {
     bool outsideBounds = false;
-    if (newPos.x < 0.0f || newPos.y < 0.0f || newPos.x > Board::boardSize || newPos.y > Board::boardSize) outsideBounds = true;
+    if (newPos.x < 0.0f || newPos.y < 0.0f || newPos.x > this->boardSize || newPos.y > this->boardSize) outsideBounds = true;
     float moveLength = glm::length((newPos - oldPos));
-    bool goesThroughWall = false;
-    for (int w = 0; w < Board::walls.length(); w++) {
-        if (Board::walls.at(w)->isInvalidMove(oldPos, newPos)) {
-            goesThroughWall = true;
-        }
-    }
+    bool goesThroughWall = wallBetween(oldPos, newPos);
 
     if (goesThroughWall || outsideBounds || moveLength > 3.0f) {
         //if (moveLength > 3.0f) qDebug() << "Attempted to move more than one unit. Resetting to previous position.";
@@ -199,7 +730,7 @@ bool Board::checkValidMove(glm::vec2 oldPos, glm::vec2 newPos) {
 // definition included here because in c++, methods must be declared before we can use them
 bool Light::moveTo(float newPosx, float newPosy) {
     glm::vec2 newPos = glm::vec2(newPosx, newPosy);
-    if (Board::checkValidMove(this->position, newPos)) {
+    if (this->board->checkValidMove(this->position, newPos)) {
         this->position = newPos;
         this->trail.append(this->position);
         return true;
@@ -209,11 +740,11 @@ bool Light::moveTo(float newPosx, float newPosy) {
 }
 
 void Light::moveRandomly() {
-    float r = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX/(2*M_PI)));
+    float r = std::uniform_real_distribution<float>(0.0f, 2*M_PI)(this->board->random);
     float deltax = 2.0f * cos(r);
     float deltay = 2.0f * sin(r);
     glm::vec2 newPos = glm::vec2(this->position.x + deltax, this->position.y + deltay);
-    if (Board::checkValidMove(this->position, newPos)) {
+    if (this->board->checkValidMove(this->position, newPos)) {
         this->position = newPos;
         this->trail.append(this->position);
     }
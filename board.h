@@ -3,40 +3,122 @@
 
 #include <QList>
 #include <QVector>
+#include <random>
+#include <vector>
+#include <utility>
+#include <exception>
 #include "mosquito.h"
 #include "light.h"
 #include "wall.h"
 #include "frog.h"
 #include "player.h"
 #include "myplayer.h"
+#include "scene.h"
+#include "lightindex.h"
+#include "arena.h"
+#include "metrics.h"
+#include "densitymap.h"
+#include "densityfield.h"
+#include "stepdelta.h"
+#include "taskpool.h"
 
 class Board
 {
 public:
     Board();
+    Board(Player* player);
+    ~Board();
 
-    QList<Mosquito*> mosquitoes;
-    QList<Light*> lights;
-    static QList<Wall*> walls;
+    QList<Mosquito*> mosquitoes; // stored next to each other in the arena, in the order of this list
+    QList<Light*> lights; // stored like the mosquitoes
+    QList<Wall*> walls;
+    Scene* scene; // compiled wall layout; when set, wall tests only look at nearby walls
     Frog* frog;
     Player* player;
+    LightIndex lightIndex; // rebuilt from the light positions every step
     QVector<QVector<int> > playerBoard; // a 2d array that contains the number of mosquitoes at each position; passed to the Playe
+    QVector<int> occupancy; // playerBoard in one block: the count of cell (x, y) is occupancy[x * (boardSize + 1) + y]
+    DensityMap density; // summed-area table and density pyramid of playerBoard, rebuilt with it
 
     int numMosquitoes;
     int numLights;
     int numWalls;
     int mosquitoesEaten;
     int mosquitoesCaught;
-    static int boardSize; // the Board is a square of boardSize x boardSize
+    int boardSize; // the Board is a square of boardSize x boardSize
     int captureTarget; // number of mosquitoes to catch in order to win
     int maxRounds; // max number of rounds/steps before game ends
     int currRound; // shows which round we're currently on
+    std::mt19937 random; // all the randomness in a game comes from here, so Boards can run side by side on different threads
+    bool pipelined; // see setPipelined
+    MetricsRecorder* metrics; // when set, every step() appends a row to it (not owned by the Board)
+    qint64 playerTime; // nanoseconds the Player spent in updateLights for the last step
+    qint64 stepTime; // nanoseconds the whole of the last step() took
+    int sortInterval; // the mosquitoes are put back in Z-order at least every sortInterval rounds (0: only by disorder)
+    float sortThreshold; // ... and as soon as mosquitoDisorder exceeds this (above 1, the default: never)
+    float mosquitoDisorder; // fraction of neighbours in the mosquito array that are out of Z-order, measured by generateBoardForPlayer
+    // generateBoardForPlayer fills playerBoard, occupancy, density and delta; players that read none of them
+    // (VecEnv's) turn this off, and playerBoard then only keeps its size
+    bool observing;
+    QVector<bool> lightMoveAccepted; // for every light, whether moveLights made the last move asked of it
+    StepDelta delta; // what changed between the last observation and the one before, published by generateBoardForPlayer
+    StepDelta nextDelta; // filled while the mosquitoes and lights move (also by the kernels), becomes delta at the next observation
+    // In hybrid mode only the mosquitoes near a light or the frog are simulated one by one (the mosquitoes
+    // list); the rest are a DensityField. Set before initialize().
+    bool hybrid;
+    float hybridMargin; // mosquitoes this far beyond the largest light radius (or the frog's) become particles
+    DensityField field; // the mosquitoes that aren't in the list in hybrid mode
+    // An uncaught mosquito so far from every light, wall, edge and the frog that nothing can reach it for
+    // a few rounds walks all of them in one draw and then rests until then, up to maxSkip rounds (0: off)
+    int maxSkip;
 
+    void seed(unsigned int seed);
+    // In pipelined mode the Player decides the light moves for the next round from the current observation
+    // on a separate thread while this round's mosquitoes move (see Player::observationLag)
+    void setPipelined(bool pipelined);
     void initialize();
     void step();
+    void moveLights(const QVector<glm::vec2>& moves); // checks all the moves (one per light) first, then makes the valid ones
+    void sortMosquitoes(); // reorders the mosquitoes (in memory and in the list) along a Z-order curve over blocks of the grid
+    void moveMosquitoes(); // moves every mosquito one step towards the closest visible light (or randomly)
+    Board* fork(bool withTrails = false); // copies the mosquitoes, lights and frog (but not the Player) so the game can be simulated ahead or drawn later (withTrails: with the trails and the last observation, for drawing)
+    void copyFrom(Board* source, bool withTrails = false); // makes this Board such a copy, reusing its arena
+    static Board* fromObservation(QVector<QVector<int> >* board, QList<Light*> lights, glm::vec2 frogPosition,
+                                  QList<Wall*> walls, Scene* scene, unsigned int seed); // rebuilds a Board (without a Player) from what the Player can see
+    void loadObservation(QVector<QVector<int> >* board, QList<Light*> lights, glm::vec2 frogPosition,
+                         QList<Wall*> walls, Scene* scene, unsigned int seed); // the same into this Board, reusing its arena
     void updateMosquitoesEaten();
+    Mosquito* mosquitoArray(); // the first mosquito, if the mosquitoes are one array in the order of the list (0 otherwise)
+    Light* lightArray(); // the same for the lights
+    bool finished(); // the capture target has been reached or maxRounds have been played
     void generateBoardForPlayer();
-    static bool checkValidMove(glm::vec2 oldPos, glm::vec2 newPos); // checks if a move is valid (i.e. doesn't go through walls or beyond boundaries)
+    bool recordsDelta(); // nextDelta is only filled for a Board whose Player gets an observation
+    void setScene(Scene* scene); // takes the walls for this game (and the Player's) from a compiled layout
+    bool wallBetween(glm::vec2 start, glm::vec2 end); // checks if a segment crosses any wall
+    bool checkValidMove(glm::vec2 oldPos, glm::vec2 newPos); // checks if a move is valid (i.e. doesn't go through walls or beyond boundaries)
+
+private:
+    Arena arena; // owns this game's mosquitoes and lights; initialize() rewinds it
+    TaskPool::Group decision; // the Player's pending decision in pipelined mode, a task on the shared pool
+    QVector<glm::vec2> plannedMoves; // the moves of the pending decision in pipelined mode (empty before the first one)
+    qint64 pendingPlayerTime; // written by the pending decision
+    std::exception_ptr decisionError; // what the pending decision threw, rethrown by waitForDecision on the Board's thread
+    void (*mosquitoKernel)(Board* board); // moveMosquitoes specialized for this game's light and wall counts, or 0 (see boardkernel.h)
+
+    void startRound();
+    void stepSequential();
+    void stepPipelined();
+    void waitForDecision(); // also rethrows what the decision threw
+    void syncPlayer();
+    void updateMosquitoKernel();
+    QList<Mosquito*> spareMosquitoes; // slots of mosquitoes that went back into the field, reused for new particles
+    Mosquito* spareMosquito();
+    int skipRounds(glm::vec2 position); // how many rounds a free mosquito here can safely walk at once
+    float wallClearance(glm::vec2 position); // the distance to the closest wall, or a lower bound on it
+    void exchangeWithField(); // turns field near the lights and the frog into particles and far particles into field
+    std::vector<std::pair<quint32, int> > sortKeys; // reused by sortMosquitoes
+    std::vector<Mosquito> sortScratch;
+    QVector<int> observedOccupancy; // occupancy as of the last observation, to find the cells that changed
 };
 
 
@@ -0,0 +1,22 @@
+#include "boardkernel.h"
+
+// the light and wall counts of the layouts we play; anything else takes the generic path
+static const struct {
+    int numLights;
+    int numWalls;
+    MosquitoKernel kernel;
+} MOSQUITO_KERNELS[] = {
+    {1, 0, &moveMosquitoesFixed<1, 0>}, {1, 1, &moveMosquitoesFixed<1, 1>}, {1, 2, &moveMosquitoesFixed<1, 2>}, {1, 4, &moveMosquitoesFixed<1, 4>},
+    {2, 0, &moveMosquitoesFixed<2, 0>}, {2, 1, &moveMosquitoesFixed<2, 1>}, {2, 2, &moveMosquitoesFixed<2, 2>}, {2, 4, &moveMosquitoesFixed<2, 4>},
+    {4, 0, &moveMosquitoesFixed<4, 0>}, {4, 1, &moveMosquitoesFixed<4, 1>}, {4, 2, &moveMosquitoesFixed<4, 2>}, {4, 4, &moveMosquitoesFixed<4, 4>},
+    {8, 0, &moveMosquitoesFixed<8, 0>}, {8, 1, &moveMosquitoesFixed<8, 1>}, {8, 2, &moveMosquitoesFixed<8, 2>}, {8, 4, &moveMosquitoesFixed<8, 4>},
+};
+
+MosquitoKernel selectMosquitoKernel(int numLights, int numWalls) {
+    for (const auto& entry : MOSQUITO_KERNELS) {
+        if (entry.numLights == numLights && entry.numWalls == numWalls) {
+            return entry.kernel;
+        }
+    }
+    return 0;
+}
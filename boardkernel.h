@@ -0,0 +1,102 @@
+#ifndef BOARDKERNEL_H
+#define BOARDKERNEL_H
+
+#include <array>
+#include <include/glm/glm.hpp>
+#include "board.h"
+
+// Mosquito step kernels for a fixed number of lights and walls. The lights and walls are copied into
+// std::arrays once per step, so the compiler can unroll the loops over them and the visibility and wall
+// tests become straight-line code. Board::initialize() picks the kernel for its light and wall counts
+// with selectMosquitoKernel, and Board::moveMosquitoes falls back to the generic path if there is none.
+// A kernel moves the mosquitoes exactly like Board::moveMosquitoes does, and records them in Board::nextDelta the same way.
+
+typedef void (*MosquitoKernel)(Board* board);
+
+// the kernel instantiated for these counts, or 0
+MosquitoKernel selectMosquitoKernel(int numLights, int numWalls);
+
+// Wall::isInvalidMove for the common case where no endpoint is collinear with the other segment;
+// the special cases go to the wall itself
+inline bool segmentCrossesWall(glm::vec2 start, glm::vec2 end, glm::vec2 point1, glm::vec2 point2, Wall* wall) {
+    float a1 = (end.x - start.x) * (point1.y - start.y) - (point1.x - start.x) * (end.y - start.y);
+    float a2 = (end.x - start.x) * (point2.y - start.y) - (point2.x - start.x) * (end.y - start.y);
+    float a3 = (point2.x - point1.x) * (start.y - point1.y) - (start.x - point1.x) * (point2.y - point1.y);
+    float a4 = (point2.x - point1.x) * (end.y - point1.y) - (end.x - point1.x) * (point2.y - point1.y);
+    if (a1 == 0.0f || a2 == 0.0f || a3 == 0.0f || a4 == 0.0f) {
+        return wall->isInvalidMove(start, end);
+    }
+    return ((a1 > 0.0f) ^ (a2 > 0.0f)) & ((a3 > 0.0f) ^ (a4 > 0.0f));
+}
+
+template <int NUM_LIGHTS, int NUM_WALLS>
+void moveMosquitoesFixed(Board* board) {
+    std::array<glm::vec2, NUM_LIGHTS> lights;
+    std::array<float, NUM_LIGHTS> radii;
+    float maxRadius = 0.0f;
+    for (int l = 0; l < NUM_LIGHTS; l++) {
+        lights[l] = board->lights.at(l)->getPosition();
+        radii[l] = board->lights.at(l)->radius;
+        maxRadius = glm::max(maxRadius, radii[l]);
+    }
+    std::array<glm::vec2, NUM_WALLS> wallStart;
+    std::array<glm::vec2, NUM_WALLS> wallEnd;
+    std::array<Wall*, NUM_WALLS> walls;
+    for (int w = 0; w < NUM_WALLS; w++) {
+        walls[w] = board->walls.at(w);
+        wallStart[w] = walls[w]->point1;
+        wallEnd[w] = walls[w]->point2;
+    }
+    glm::vec2 frogPosition = board->frog->position;
+    float frogRadius2 = board->frog->radius * board->frog->radius;
+    float boardSize = board->boardSize;
+    bool record = board->recordsDelta();
+
+    for (int i = 0; i < board->mosquitoes.length(); i++) {
+        Mosquito* m = board->mosquitoes.at(i);
+        glm::vec2 position = m->position;
+        bool wasCaught = m->isCaught;
+        bool wasEaten = m->isEaten;
+        glm::vec2 toFrog = position - frogPosition;
+        if (toFrog.x * toFrog.x + toFrog.y * toFrog.y < frogRadius2) {
+            m->isEaten = true;
+            if (record) board->nextDelta.recordMosquito(m, wasCaught, wasEaten);
+            continue;
+        }
+
+        // the closest light whose radius covers the mosquito and that no wall hides
+        int closest = -1;
+        float bestDistance = maxRadius;
+        for (int l = 0; l < NUM_LIGHTS; l++) {
+            float distance = glm::length(lights[l] - position);
+            bool blocked = false;
+            for (int w = 0; w < NUM_WALLS; w++) {
+                blocked |= segmentCrossesWall(position, lights[l], wallStart[w], wallEnd[w], walls[w]);
+            }
+            if (distance < bestDistance && distance < radii[l] && !blocked) {
+                bestDistance = distance;
+                closest = l;
+            }
+        }
+
+        glm::vec2 closestLightPos;
+        m->isCaught = closest >= 0;
+        if (m->isCaught) {
+            board->mosquitoesCaught++;
+            closestLightPos = lights[closest];
+        }
+
+        glm::vec2 nextMove = m->calculateNextMove(closestLightPos, board->random);
+        bool valid = nextMove.x >= 0.0f && nextMove.y >= 0.0f && nextMove.x <= boardSize && nextMove.y <= boardSize &&
+                glm::length(nextMove - position) <= 3.0f;
+        for (int w = 0; w < NUM_WALLS; w++) {
+            valid = valid && !segmentCrossesWall(position, nextMove, wallStart[w], wallEnd[w], walls[w]);
+        }
+        if (valid) {
+            m->move(nextMove);
+        }
+        if (record) board->nextDelta.recordMosquito(m, wasCaught, wasEaten);
+    }
+}
+
+#endif // BOARDKERNEL_H
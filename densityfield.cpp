@@ -0,0 +1,125 @@
+#include "densityfield.h"
+#include "board.h"
+#include <string.h>
+
+// fraction of the difference between two neighbouring cells that flows across their edge per substep;
+// each substep adds 2 * DIFFUSION_RATE to the variance per axis, so the substeps add up to one round
+static const float DIFFUSION_RATE = 0.125f;
+static const int DIFFUSION_SUBSTEPS = 8;
+
+DensityField::DensityField()
+{
+    this->count = 0;
+    this->cells = 0;
+}
+
+void DensityField::reset(Board* board) {
+    int n = board->boardSize + 1;
+    this->cells = n;
+    this->count = 0;
+    this->amount.fill(0.0f, n * n);
+    this->next.fill(0.0f, n * n);
+    this->open.fill(0, n * n);
+    for (int x = 0; x < n; x++) {
+        for (int y = 0; y < n; y++) {
+            glm::vec2 centre(x + 0.5f, y + 0.5f);
+            unsigned char flags = 0;
+            if (x + 1 < n && !board->wallBetween(centre, centre + glm::vec2(1.0f, 0.0f))) flags |= 1;
+            if (y + 1 < n && !board->wallBetween(centre, centre + glm::vec2(0.0f, 1.0f))) flags |= 2;
+            this->open[x * n + y] = flags;
+        }
+    }
+}
+
+bool DensityField::isEmpty() {
+    return this->count == 0;
+}
+
+int DensityField::size() {
+    return this->cells;
+}
+
+void DensityField::add(glm::vec2 position) {
+    int x = glm::clamp((int) glm::floor(position.x), 0, this->cells - 1);
+    int y = glm::clamp((int) glm::floor(position.y), 0, this->cells - 1);
+    this->amount[x * this->cells + y] += 1.0f;
+    this->count++;
+}
+
+float DensityField::at(int x, int y) {
+    return this->amount.at(x * this->cells + y);
+}
+
+int DensityField::take(int x, int y, std::mt19937& random) {
+    float& cell = this->amount[x * this->cells + y];
+    if (cell <= 0.0f) {
+        return 0;
+    }
+    int result = (int) glm::floor(cell);
+    if (std::uniform_real_distribution<float>(0.0f, 1.0f)(random) < cell - result) {
+        result++;
+    }
+    result = glm::min(result, this->count);
+    cell = 0.0f;
+    this->count -= result;
+    return result;
+}
+
+void DensityField::diffuse() {
+    if (this->count == 0) {
+        return;
+    }
+    int n = this->cells;
+    for (int s = 0; s < DIFFUSION_SUBSTEPS; s++) {
+        const float* from = this->amount.constData();
+        float* to = this->next.data();
+        memcpy(to, from, n * n * sizeof(float));
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                int c = x * n + y;
+                unsigned char flags = this->open[c];
+                if (flags & 1) {
+                    float flow = DIFFUSION_RATE * (from[c] - from[c + n]);
+                    to[c] -= flow;
+                    to[c + n] += flow;
+                }
+                if (flags & 2) {
+                    float flow = DIFFUSION_RATE * (from[c] - from[c + 1]);
+                    to[c] -= flow;
+                    to[c + 1] += flow;
+                }
+            }
+        }
+        this->amount.swap(this->next);
+    }
+
+    // the flows cancel out exactly in theory; scale away the rounding so the amounts keep adding up to count
+    double total = 0.0;
+    for (int c = 0; c < n * n; c++) {
+        total += this->amount.at(c);
+    }
+    if (total > 0.0) {
+        float scale = this->count / total;
+        float* cells = this->amount.data();
+        for (int c = 0; c < n * n; c++) {
+            cells[c] *= scale;
+        }
+    }
+}
+
+void DensityField::addCounts(int* counts) {
+    if (this->count == 0) {
+        return;
+    }
+    float carry = 0.0f;
+    int added = 0;
+    for (int c = 0; c < this->cells * this->cells; c++) {
+        float value = this->amount.at(c) + carry;
+        int whole = (int) glm::floor(value + 0.5f);
+        carry = value - whole;
+        counts[c] += whole;
+        added += whole;
+    }
+    // float rounding in the carry can leave the total one off; the last cell absorbs it
+    counts[this->cells * this->cells - 1] += this->count - added;
+}
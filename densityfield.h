@@ -0,0 +1,42 @@
+#ifndef DENSITYFIELD_H
+#define DENSITYFIELD_H
+
+#include <QVector>
+#include <random>
+#include <include/glm/glm.hpp>
+
+class Board;
+
+// Mosquitoes that are far from every light, kept as an amount per board cell instead of one by one
+// (see Board::hybrid). Every round the amounts spread like the random walk of the mosquitoes would:
+// a step of length 2 in a random direction has a variance of 2 per axis, which diffuse() matches with
+// explicit diffusion substeps. Walls block the flow between the cells on either side of them, and the
+// edges of the board block it too, like the moves the Board rejects.
+class DensityField
+{
+public:
+    DensityField();
+
+    void reset(Board* board); // empties the field and works out which cells the walls separate
+    bool isEmpty();
+    int size(); // cells per side (boardSize + 1, like playerBoard)
+    int count; // mosquitoes in the field; the amounts always add up to this
+
+    void add(glm::vec2 position); // takes a mosquito into the field
+    float at(int x, int y);
+    // removes the mosquitoes of a cell from the field and returns how many there were; a fractional
+    // amount is rounded up or down at random, so the expected number is the amount
+    int take(int x, int y, std::mt19937& random);
+    void diffuse(); // one round of random walk
+    // adds the field to counts (size x size, x-major) as whole mosquitoes, carrying the rounding error
+    // from cell to cell so the counts add up to count
+    void addCounts(int* counts);
+
+private:
+    int cells;
+    QVector<float> amount; // x-major
+    QVector<float> next;
+    QVector<unsigned char> open; // bit 0: mosquitoes can go from (x, y) to (x + 1, y), bit 1: to (x, y + 1)
+};
+
+#endif // DENSITYFIELD_H
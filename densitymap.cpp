@@ -0,0 +1,104 @@
+#include "densitymap.h"
+#include <math.h>
+
+DensityMap::DensityMap()
+{
+    this->boardSize = 0;
+}
+
+int DensityMap::tableAt(int x, int y) {
+    return this->table[x * (this->boardSize + 1) + y];
+}
+
+void DensityMap::rebuild(const QVector<QVector<int> >& board) {
+    int n = board.size();
+    if (n != this->boardSize) {
+        this->boardSize = n;
+        this->table.fill(0, (n + 1) * (n + 1));
+        this->levelSizes.clear();
+        this->levels.clear();
+        this->levelSizes.append(n);
+        this->levels.append(QVector<int>()); // level 0 is the board
+        for (int size = (n + 1) / 2; n > 1; size = (size + 1) / 2) {
+            this->levelSizes.append(size);
+            this->levels.append(QVector<int>(size * size));
+            if (size == 1) {
+                break;
+            }
+        }
+    }
+
+    // table[x+1][y+1] = board[x][y] + table[x][y+1] + table[x+1][y] - table[x][y]
+    int stride = n + 1;
+    for (int x = 0; x < n; x++) {
+        const QVector<int>& column = board.at(x);
+        int* previous = &this->table[x * stride];
+        int* current = &this->table[(x + 1) * stride];
+        int columnSum = 0;
+        for (int y = 0; y < n; y++) {
+            columnSum += y < column.size() ? column.at(y) : 0;
+            current[y + 1] = previous[y + 1] + columnSum;
+        }
+    }
+
+    // every cell of a level covers a square of the board, which the table counts with four lookups
+    for (int l = 1; l < this->levels.size(); l++) {
+        int size = this->levelSizes.at(l);
+        int span = 1 << l;
+        QVector<int>& level = this->levels[l];
+        for (int x = 0; x < size; x++) {
+            for (int y = 0; y < size; y++) {
+                level[x * size + y] = count(x * span, y * span, (x + 1) * span - 1, (y + 1) * span - 1);
+            }
+        }
+    }
+}
+
+int DensityMap::size() {
+    return this->boardSize;
+}
+
+int DensityMap::total() {
+    return this->boardSize > 0 ? tableAt(this->boardSize, this->boardSize) : 0;
+}
+
+int DensityMap::count(int x0, int y0, int x1, int y1) {
+    x0 = glm::max(x0, 0);
+    y0 = glm::max(y0, 0);
+    x1 = glm::min(x1, this->boardSize - 1);
+    y1 = glm::min(y1, this->boardSize - 1);
+    if (x0 > x1 || y0 > y1) {
+        return 0;
+    }
+    return tableAt(x1 + 1, y1 + 1) - tableAt(x0, y1 + 1) - tableAt(x1 + 1, y0) + tableAt(x0, y0);
+}
+
+int DensityMap::countInCircle(glm::vec2 center, float radius) {
+    // one rectangle query per column: the cells of column x whose centres are inside the circle
+    int result = 0;
+    int xStart = (int) ceil(center.x - radius - 0.5f);
+    int xEnd = (int) floor(center.x + radius - 0.5f);
+    for (int x = glm::max(xStart, 0); x <= glm::min(xEnd, this->boardSize - 1); x++) {
+        float dx = x + 0.5f - center.x;
+        float halfHeight = sqrt(glm::max(radius * radius - dx * dx, 0.0f));
+        int y0 = (int) ceil(center.y - halfHeight - 0.5f);
+        int y1 = (int) floor(center.y + halfHeight - 0.5f);
+        result += count(x, y0, x, y1);
+    }
+    return result;
+}
+
+int DensityMap::numLevels() {
+    return this->levelSizes.size();
+}
+
+int DensityMap::levelSize(int level) {
+    return this->levelSizes.at(level);
+}
+
+int DensityMap::at(int level, int x, int y) {
+    if (level == 0) {
+        return count(x, y, x, y);
+    }
+    return this->levels.at(level).at(x * this->levelSizes.at(level) + y);
+}
@@ -0,0 +1,38 @@
+#ifndef DENSITYMAP_H
+#define DENSITYMAP_H
+
+#include <QVector>
+#include <include/glm/glm.hpp>
+
+// Summed-area table and a pyramid of coarser density grids over the Player's board, so strategies can count
+// the mosquitoes in a region without visiting every cell. Level 0 of the pyramid is the board itself; every
+// further level halves the size (rounding up), so each of its cells holds the sum of 2x2 cells of the level below.
+class DensityMap
+{
+public:
+    DensityMap();
+
+    void rebuild(const QVector<QVector<int> >& board); // board[x][y], like the board passed to Player::updateLights
+
+    int size(); // of the board
+    int total(); // number of mosquitoes on the board
+
+    // number of mosquitoes in the cells from (x0, y0) up to and including (x1, y1); the rectangle is clipped to the board
+    int count(int x0, int y0, int x1, int y1);
+    // number of mosquitoes in the cells whose centre lies within radius of center
+    int countInCircle(glm::vec2 center, float radius);
+
+    int numLevels();
+    int levelSize(int level);
+    int at(int level, int x, int y); // mosquitoes in cell (x, y) of a level, covering 2^level x 2^level board cells
+
+private:
+    int boardSize;
+    QVector<int> table; // (boardSize + 1)^2; table[x][y] is the number of mosquitoes in the cells below x and y
+    QVector<QVector<int> > levels; // levels[l] holds levelSizes[l]^2 counts, x-major; level 0 is the table
+    QVector<int> levelSizes;
+
+    int tableAt(int x, int y);
+};
+
+#endif // DENSITYMAP_H
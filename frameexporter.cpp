@@ -0,0 +1,114 @@
+#include "frameexporter.h"
+#include "board.h"
+#include "helper.h"
+#include <QPainter>
+#include <QRunnable>
+#include <QThread>
+#include <QDir>
+#include <stdio.h>
+
+// Draws one snapshot and hands the image back to the exporter
+class FrameJob : public QRunnable
+{
+public:
+    FrameJob(FrameExporter* exporter, Board* snapshot, int frame)
+    {
+        this->exporter = exporter;
+        this->snapshot = snapshot;
+        this->frame = frame;
+    }
+
+    void run() {
+        QImage image(this->exporter->size, this->exporter->size, QImage::Format_RGB32);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        // every job has its own Helper, since drawing changes the Helper's pen
+        Helper helper(this->snapshot);
+        helper.render(&painter, image.rect());
+        painter.end();
+        delete this->snapshot;
+        this->exporter->frameDone(this->frame, image);
+    }
+
+private:
+    FrameExporter* exporter;
+    Board* snapshot;
+    int frame;
+};
+
+FrameExporter::FrameExporter()
+{
+    this->size = 500;
+    this->maxPending = 4 * QThread::idealThreadCount();
+    this->pool.setMaxThreadCount(QThread::idealThreadCount());
+    this->format = PNG;
+    this->nextFrame = 0;
+    this->nextWrite = 0;
+    this->written = 0;
+}
+
+FrameExporter::~FrameExporter() {
+    finish();
+}
+
+bool FrameExporter::open(const QString& path, Format format) {
+    finish();
+    this->format = format;
+    this->nextFrame = 0;
+    this->nextWrite = 0;
+    this->written = 0;
+    this->freeSlots.acquire(this->freeSlots.available());
+    this->freeSlots.release(this->maxPending);
+
+    if (format == PNG) {
+        this->directory = path;
+        return QDir().mkpath(path);
+    }
+    if (path == "-") {
+        return this->stream.open(stdout, QIODevice::WriteOnly);
+    }
+    this->stream.setFileName(path);
+    return this->stream.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+void FrameExporter::addFrame(Board* board) {
+    // don't let the game run arbitrarily far ahead of the workers
+    this->freeSlots.acquire();
+    this->pool.start(new FrameJob(this, board->fork(true), this->nextFrame));
+    this->nextFrame++;
+}
+
+void FrameExporter::frameDone(int frame, const QImage& image) {
+    if (this->format == PNG) {
+        image.save(QString("%1/frame_%2.png").arg(this->directory).arg(frame, 6, 10, QChar('0')));
+        QMutexLocker locker(&this->mutex);
+        this->written++;
+        this->freeSlots.release();
+        return;
+    }
+
+    // the stream has to stay in order, so whoever finishes the next frame writes every frame that is ready
+    QMutexLocker locker(&this->mutex);
+    this->finished.insert(frame, image);
+    while (this->finished.contains(this->nextWrite)) {
+        QImage next = this->finished.take(this->nextWrite);
+        for (int y = 0; y < next.height(); y++) {
+            this->stream.write(reinterpret_cast<const char*>(next.constScanLine(y)), next.width() * 4);
+        }
+        this->nextWrite++;
+        this->written++;
+        this->freeSlots.release();
+    }
+}
+
+void FrameExporter::finish() {
+    this->pool.waitForDone();
+    if (this->stream.isOpen()) {
+        this->stream.close();
+    }
+}
+
+int FrameExporter::framesWritten() {
+    QMutexLocker locker(&this->mutex);
+    return this->written;
+}
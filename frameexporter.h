@@ -0,0 +1,50 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QString>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QFile>
+
+class Board;
+
+// Renders Board states with Helper's drawing code into QImages on a pool of worker threads, without a display.
+// Frames are written as a numbered PNG sequence (frame_000000.png, ...) or appended in order to one raw stream
+// of size x size 32-bit BGRX pixels per frame, e.g. for ffmpeg -f rawvideo -pix_fmt bgr0 -s 500x500 -i -
+class FrameExporter
+{
+public:
+    enum Format { PNG, RAW };
+
+    FrameExporter();
+    ~FrameExporter();
+
+    int size; // width and height of the frames in pixels
+    int maxPending; // frames that can be queued or waiting to be written before addFrame blocks
+
+    // For PNG, path is a directory (created if needed); for RAW it is a file, or "-" for stdout
+    bool open(const QString& path, Format format);
+    void addFrame(Board* board); // snapshots the board now; it can keep stepping while the frame is drawn
+    void finish(); // waits for every frame to be written and closes the output
+    int framesWritten();
+
+private:
+    QThreadPool pool;
+    QSemaphore freeSlots; // one per frame that may still be pending
+    QMutex mutex;
+    QMap<int, QImage> finished; // RAW frames that are drawn but still wait for earlier ones
+    QFile stream;
+    QString directory;
+    Format format;
+    int nextFrame; // number of the next frame passed to addFrame
+    int nextWrite; // number of the next RAW frame to be written
+    int written;
+
+    friend class FrameJob;
+    void frameDone(int frame, const QImage& image);
+};
+
+#endif // FRAMEEXPORTER_H
@@ -4,6 +4,7 @@
 #include <QPaintEvent>
 #include <QWidget>
 #include <QDebug>
+#include <math.h>
 
 Helper::Helper()
 {
@@ -11,22 +12,66 @@ Helper::Helper()
     circlePen = QPen(Qt::white);
     circlePen.setWidth(1);
     b = new Board();
+    initColormap();
 }
 
-void Helper::paint(QPainter *painter, QPaintEvent *event, int elapsed, bool timerStopped)
+Helper::Helper(Board* board)
 {
+    background = QBrush(QColor(64, 32, 64));
+    circlePen = QPen(Qt::white);
+    circlePen.setWidth(1);
+    b = board;
+    initColormap();
+}
+
+void Helper::initColormap() {
+    this->lodThreshold = 2000;
+    this->heatmapBlur = 1;
 
+    // dark red through orange and yellow to white, fading in from transparent
+    const int numStops = 5;
+    const int stops[numStops][4] = {{128, 0, 0, 0}, {160, 20, 20, 160}, {230, 90, 0, 220}, {255, 220, 0, 255}, {255, 255, 255, 255}};
+    this->colormap.resize(256);
+    this->colormap[0] = qRgba(0, 0, 0, 0);
+    for (int i = 1; i < 256; i++) {
+        float t = (i / 255.0f) * (numStops - 1);
+        int s = glm::min((int) t, numStops - 2);
+        float f = t - s;
+        int color[4];
+        for (int c = 0; c < 4; c++) {
+            color[c] = (int) (stops[s][c] * (1 - f) + stops[s + 1][c] * f);
+        }
+        this->colormap[i] = qPremultiply(qRgba(color[0], color[1], color[2], color[3]));
+    }
+}
+
+void Helper::paint(QPainter *painter, QPaintEvent *event, int elapsed, bool timerStopped)
+{
+    // the widget shows the board at its own size
     painter->fillRect(event->rect(), background);
+    render(painter, QRect(0, 0, b->boardSize, b->boardSize));
+}
+
+void Helper::render(QPainter *painter, const QRect& rect)
+{
+    painter->fillRect(rect, background);
+    painter->save();
+    painter->translate(rect.x(), rect.y());
+    painter->scale(rect.width() / (float) b->boardSize, rect.height() / (float) b->boardSize);
 
     for (int i = 0; i < b->lights.length(); i++) {
         glm::vec2 position = b->lights.at(i)->getPosition();
         drawLight(painter, position.x, position.y, b->lights.at(i)->radius);
-        drawTrail(painter, b->lights.at(i)->trail, b->lights.at(i)->trailColor);
     }
+    drawTrails(painter, rect);
 
-    for (int j = 0; j < b->mosquitoes.length(); j++) {
-        if (!b->mosquitoes.at(j)->isEaten) {
-            drawMosquito(painter, b->mosquitoes.at(j)->position.x, b->mosquitoes.at(j)->position.y);
+    if (b->mosquitoes.length() > this->lodThreshold || !b->field.isEmpty()) {
+        drawHeatmap(painter);
+    } else {
+        for (int j = 0; j < b->mosquitoes.length(); j++) {
+            if (!b->mosquitoes.at(j)->isEaten) {
+                drawMosquito(painter, b->mosquitoes.at(j)->position.x, b->mosquitoes.at(j)->position.y);
+            }
         }
     }
 
@@ -35,6 +80,7 @@ void Helper::paint(QPainter *painter, QPaintEvent *event, int elapsed, bool time
     }
 
     drawFrog(painter, b->frog->position.x, b->frog->position.y, b->frog->radius);
+    painter->restore();
 }
 
 void Helper::drawFrog(QPainter *painter, float px, float py, float radius) {
@@ -64,6 +110,87 @@ void Helper::drawMosquito(QPainter *painter, float px, float py) {
     painter->drawLine(QPointF(px - mosquitoSize, py + mosquitoSize), QPoint(px + mosquitoSize, py - mosquitoSize));
 }
 
+// One pixel per board cell: take the counts per cell, blur, map through the colormap and draw the image once
+void Helper::drawHeatmap(QPainter *painter) {
+    // the cells of the Player's board, which include the one past the far edges
+    int size = b->boardSize + 1;
+    if (this->heatmap.width() != size || this->heatmap.height() != size) {
+        this->heatmap = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+        this->density.resize(size * size);
+        this->blurred.resize(size * size);
+    }
+    if (b->occupancy.size() == size * size) {
+        // the counts from the last observation, field included, so a frame costs the same for any swarm
+        const int* counts = b->occupancy.constData();
+        for (int x = 0; x < size; x++) {
+            for (int y = 0; y < size; y++) {
+                this->density[y * size + x] = counts[x * size + y];
+            }
+        }
+    } else {
+        // a Board that has never been observed has to be counted here
+        this->density.fill(0);
+        for (int j = 0; j < b->mosquitoes.length(); j++) {
+            Mosquito* m = b->mosquitoes.at(j);
+            int x = (int) m->position.x;
+            int y = (int) m->position.y;
+            if (!m->isEaten && x >= 0 && y >= 0 && x < size && y < size) {
+                this->density[y * size + x]++;
+            }
+        }
+        if (b->field.size() == size) {
+            for (int x = 0; x < size; x++) {
+                for (int y = 0; y < size; y++) {
+                    this->density[y * size + x] += (int) (b->field.at(x, y) + 0.5f);
+                }
+            }
+        }
+    }
+
+    // separable box blur with running sums: rows into blurred, then columns back into density
+    int r = this->heatmapBlur;
+    if (r > 0) {
+        for (int y = 0; y < size; y++) {
+            const int* row = this->density.constData() + y * size;
+            int sum = 0;
+            for (int x = 0; x < r && x < size; x++) {
+                sum += row[x];
+            }
+            for (int x = 0; x < size; x++) {
+                if (x + r < size) sum += row[x + r];
+                if (x - r - 1 >= 0) sum -= row[x - r - 1];
+                this->blurred[y * size + x] = sum;
+            }
+        }
+        for (int x = 0; x < size; x++) {
+            int sum = 0;
+            for (int y = 0; y < r && y < size; y++) {
+                sum += this->blurred[y * size + x];
+            }
+            for (int y = 0; y < size; y++) {
+                if (y + r < size) sum += this->blurred[(y + r) * size + x];
+                if (y - r - 1 >= 0) sum -= this->blurred[(y - r - 1) * size + x];
+                this->density[y * size + x] = sum;
+            }
+        }
+    }
+
+    int maxDensity = 0;
+    for (int i = 0; i < size * size; i++) {
+        maxDensity = glm::max(maxDensity, this->density.at(i));
+    }
+    // log scale, so single mosquitoes still show up next to dense clusters
+    float scale = maxDensity > 0 ? 255.0f / log(1.0f + maxDensity) : 0.0f;
+    for (int y = 0; y < size; y++) {
+        QRgb* line = reinterpret_cast<QRgb*>(this->heatmap.scanLine(y));
+        const int* row = this->density.constData() + y * size;
+        for (int x = 0; x < size; x++) {
+            line[x] = row[x] == 0 ? this->colormap.at(0) : this->colormap.at(glm::max(1, (int) (log(1.0f + row[x]) * scale)));
+        }
+    }
+    painter->drawImage(QRect(0, 0, size, size), this->heatmap);
+}
+
 void Helper::drawWall(QPainter *painter, float px, float py, float p1x, float p1y) {
     circlePen = QPen(Qt::red);
     circlePen.setWidth(2);
@@ -72,14 +199,55 @@ void Helper::drawWall(QPainter *painter, float px, float py, float p1x, float p1
     painter->drawLine(QPointF(px, py), QPoint(p1x, p1y));
 }
 
-void Helper::drawTrail(QPainter *painter, QList<glm::vec2> points, QColor trailColor) {
+void Helper::invalidateTrails() {
+    this->trailLayer = QImage();
+}
+
+// The trails only ever grow during a game, so only the segments added since the last paint are drawn into the layer
+void Helper::drawTrails(QPainter *painter, const QRect& rect) {
+    bool reset = this->trailLayer.isNull() || this->trailLayer.size() != rect.size() ||
+            this->trailDrawn.size() != b->lights.length();
+    for (int i = 0; i < b->lights.length() && !reset; i++) {
+        const QList<glm::vec2>& trail = b->lights.at(i)->trail;
+        // a trail that got shorter or starts somewhere else belongs to a new game (or was rolled back)
+        if (trail.length() < this->trailDrawn.at(i) || (!trail.isEmpty() && trail.first() != this->trailStart.at(i))) {
+            reset = true;
+        }
+    }
+    if (reset) {
+        this->trailLayer = QImage(rect.size(), QImage::Format_ARGB32_Premultiplied);
+        this->trailLayer.fill(Qt::transparent);
+        this->trailDrawn.fill(0, b->lights.length());
+        this->trailStart.fill(glm::vec2(0.0f, 0.0f), b->lights.length());
+        for (int i = 0; i < b->lights.length(); i++) {
+            if (!b->lights.at(i)->trail.isEmpty()) {
+                this->trailStart[i] = b->lights.at(i)->trail.first();
+            }
+        }
+    }
+
+    QPainter layer(&this->trailLayer);
+    layer.setRenderHint(QPainter::Antialiasing, painter->renderHints() & QPainter::Antialiasing);
+    layer.scale(rect.width() / (float) b->boardSize, rect.height() / (float) b->boardSize);
+    for (int i = 0; i < b->lights.length(); i++) {
+        this->trailDrawn[i] = drawTrail(&layer, b->lights.at(i)->trail, b->lights.at(i)->trailColor, this->trailDrawn.at(i));
+    }
+    layer.end();
+
+    painter->drawImage(QRect(0, 0, b->boardSize, b->boardSize), this->trailLayer);
+}
+
+// draws every other segment of the trail, starting at point from; returns where the next call should start
+int Helper::drawTrail(QPainter *painter, const QList<glm::vec2>& points, QColor trailColor, int from) {
     circlePen = QPen(trailColor);
     circlePen.setWidth(1);
     painter->setPen(circlePen);
 
-   for (int i = 0; i < points.length() - 1; i += 2) {
+    int i = from;
+    for (; i < points.length() - 1; i += 2) {
         painter->drawLine(QPoint(points.at(i).x, points.at(i).y), QPoint(points.at(i+1).x, points.at(i+1).y));
     }
+    return i;
 }
 
 void Helper::drawDot(QPainter *painter, float px, float py, float radius) {
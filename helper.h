@@ -4,6 +4,8 @@
 #include <QBrush>
 #include <QFont>
 #include <QPen>
+#include <QImage>
+#include <QVector>
 #include <QWidget>
 #include "board.h"
 
@@ -11,21 +13,37 @@ class Helper
 {
 public:
     Helper();
+    Helper(Board* board); // draws a Board owned by someone else (e.g. a snapshot for the FrameExporter)
 
 public:
     void paint(QPainter *painter, QPaintEvent *event, int elapsed, bool timerStopped);
+    void render(QPainter *painter, const QRect& rect); // draws b scaled to rect; works on any paint device, e.g. a QImage
     Board* b;
+    int lodThreshold; // above this many mosquitoes they are drawn as a density heatmap instead of one by one
+    int heatmapBlur; // radius (in cells) of the box blur applied to the heatmap; 0 turns it off
+    void invalidateTrails(); // redraw the trails from scratch on the next paint (done automatically on a new game or resize)
 
 private:
     QBrush background;
     QBrush circleBrush;
     QPen circlePen;
+    QVector<QRgb> colormap; // heat (0 to 255) to premultiplied color; 0 is transparent
+    QVector<int> density; // mosquitoes per board cell, reused between frames
+    QVector<int> blurred;
+    QImage heatmap;
+    QImage trailLayer; // the trails drawn so far, at the size of the rect they are painted into
+    QVector<int> trailDrawn; // per light, the first trail point whose segment isn't in trailLayer yet
+    QVector<glm::vec2> trailStart; // per light, the first trail point when trailLayer was started (it changes with every new game)
+
+    void initColormap();
 
     void drawFrog(QPainter *painter, float px, float py, float radius);
     void drawLight(QPainter *painter, float px, float py, float radius);
     void drawMosquito(QPainter *painter, float px, float py);
+    void drawHeatmap(QPainter *painter);
     void drawWall(QPainter *painter, float px1, float py1, float p1x, float p1y);
-    void drawTrail(QPainter *painter, QList<glm::vec2> points, QColor trailColor);
+    void drawTrails(QPainter *painter, const QRect& rect);
+    int drawTrail(QPainter *painter, const QList<glm::vec2>& points, QColor trailColor, int from);
     void drawDot(QPainter *painter, float px, float py, float radius);
 };
 
@@ -4,6 +4,7 @@
 Light::Light()
 {
     this->radius = 100;
+    this->board = 0;
     int r =  250; //rand() % 255;
     int r1 = 50; //rand() % 255;
     int r2 = 250; //rand() % 255;
@@ -22,14 +23,6 @@ void Light::setInitialPosition(float posx, float posy) {
     this->trail.append(this->position);
 }
 
-void Light::returnToPreviousPosition() {
-    if (trail.size() > 1) {
-        glm::vec2 saved = this->trail.takeLast();
-//        qDebug() << this->position.x << this->position.y;
-//        qDebug() << saved.x << saved.y;
-
-        this->position = saved;
-    } else {
-        this->position = this->trail.first();
-    }
+void Light::placeAt(glm::vec2 pos) {
+    this->position = pos;
 }
@@ -5,25 +5,31 @@
 #include <include/glm/glm.hpp>
 #include <QColor>
 
+class Board;
+
 class Light
 {
 public:
     Light();
 
     int radius;
+    Board* board; // the Board this Light belongs to; moves are validated against its walls and bounds
 
     QList<glm::vec2> trail;
     QColor trailColor;
     void moveRandomly(); // just randomly moves Light (definiton is in board.cpp)
 
     void setInitialPosition(float posx, float posy); // use this method to define initial positions for your Lights
-    bool moveTo(float newPosx, float newPosy); // use this method when moving the Lights through the Player class (definition in board.cpp)
+    bool moveTo(float newPosx, float newPosy); // moves the Light if the move is valid (definition in board.cpp); Players return their moves from updateLights instead
 
     glm::vec2 getPosition();
-    void returnToPreviousPosition();
+    const glm::vec2* positionData() const { return &this->position; } // for views straight into the Board's memory (see python/)
 
 private:
     glm::vec2 position;
+
+    friend class Board;
+    void placeAt(glm::vec2 pos); // lets the Board commit a move it has already checked
 };
 
 #endif // LIGHT_H
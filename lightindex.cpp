@@ -0,0 +1,109 @@
+#include "lightindex.h"
+#include "scene.h"
+#include <math.h>
+
+LightIndex::LightIndex()
+{
+    this->maxRadius = 0.0f;
+    this->gridSize = 1;
+    this->cellSize = 1.0f;
+}
+
+int LightIndex::cellIndex(float coord) {
+    int cell = (int) glm::floor(coord / this->cellSize);
+    if (cell < 0) return 0;
+    if (cell >= this->gridSize) return this->gridSize - 1;
+    return cell;
+}
+
+glm::vec2 LightIndex::position(int light) {
+    return this->positions.at(light);
+}
+
+void LightIndex::rebuild(QList<Light*> lights, float boardSize) {
+    int numLights = lights.length();
+    this->positions.resize(numLights);
+    this->radii.resize(numLights);
+    this->maxRadius = 0.0f;
+    for (int l = 0; l < numLights; l++) {
+        this->positions[l] = lights.at(l)->getPosition();
+        this->radii[l] = lights.at(l)->radius;
+        this->maxRadius = glm::max(this->maxRadius, this->radii[l]);
+    }
+
+    // aim for about two lights per cell
+    this->gridSize = (int) ceil(sqrt(numLights / 2.0));
+    if (this->gridSize < 1) this->gridSize = 1;
+    if (this->gridSize > 64) this->gridSize = 64;
+    this->cellSize = boardSize / this->gridSize;
+
+    // counting sort of the lights by cell
+    int numCells = this->gridSize * this->gridSize;
+    this->cellStart.fill(0, numCells + 1);
+    this->cellLights.resize(numLights);
+    for (int l = 0; l < numLights; l++) {
+        int cell = cellIndex(this->positions[l].x) * this->gridSize + cellIndex(this->positions[l].y);
+        this->cellStart[cell + 1]++;
+    }
+    for (int c = 0; c < numCells; c++) {
+        this->cellStart[c + 1] += this->cellStart[c];
+    }
+    for (int l = 0; l < numLights; l++) {
+        int cell = cellIndex(this->positions[l].x) * this->gridSize + cellIndex(this->positions[l].y);
+        this->cellLights[this->cellStart[cell]++] = l;
+    }
+    // placing the lights advanced every start to the start of the next cell, so shift them back
+    for (int c = numCells; c > 0; c--) {
+        this->cellStart[c] = this->cellStart[c - 1];
+    }
+    this->cellStart[0] = 0;
+}
+
+int LightIndex::nearestVisible(glm::vec2 pos, float maxDistance, bool withinRadius, const QList<Wall*>& walls, Scene* scene) {
+    int cx = cellIndex(pos.x);
+    int cy = cellIndex(pos.y);
+    float bestDistance = maxDistance;
+    if (withinRadius) {
+        bestDistance = glm::min(bestDistance, this->maxRadius);
+    }
+    int best = -1;
+
+    // visit rings of cells around pos until no closer light can be found
+    for (int r = 0; r < this->gridSize; r++) {
+        // every cell in ring r is at least (r - 1) cells away from pos
+        if (r > 0 && (r - 1) * this->cellSize >= bestDistance) {
+            break;
+        }
+        for (int x = cx - r; x <= cx + r; x++) {
+            if (x < 0 || x >= this->gridSize) continue;
+            bool edge = x == cx - r || x == cx + r;
+            for (int y = cy - r; y <= cy + r; y += (edge || r == 0) ? 1 : 2 * r) {
+                if (y < 0 || y >= this->gridSize) continue;
+                int cell = x * this->gridSize + y;
+                for (int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; i++) {
+                    int l = this->cellLights[i];
+                    float distance = glm::length(this->positions[l] - pos);
+                    if (distance >= bestDistance) continue;
+                    if (withinRadius && distance >= this->radii[l]) continue;
+
+                    bool wallInWay = false;
+                    if (scene && scene->isLoaded()) {
+                        wallInWay = scene->segmentHitsWall(pos, this->positions[l]);
+                    } else {
+                        for (int w = 0; w < walls.length(); w++) {
+                            if (walls.at(w)->isInvalidMove(pos, this->positions[l])) {
+                                wallInWay = true;
+                                break;
+                            }
+                        }
+                    }
+                    if (!wallInWay) {
+                        bestDistance = distance;
+                        best = l;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
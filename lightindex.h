@@ -0,0 +1,40 @@
+#ifndef LIGHTINDEX_H
+#define LIGHTINDEX_H
+
+#include <QList>
+#include <QVector>
+#include <include/glm/glm.hpp>
+#include "light.h"
+#include "wall.h"
+
+class Scene;
+
+// Uniform grid over the light positions, rebuilt every step, for finding the closest light
+// a mosquito can see without scanning every light.
+class LightIndex
+{
+public:
+    LightIndex();
+
+    void rebuild(QList<Light*> lights, float boardSize); // call whenever the lights have moved
+
+    // Returns the index (in the list passed to rebuild) of the closest light within maxDistance that isn't
+    // hidden behind one of the walls, or -1. If withinRadius is set, only lights whose radius covers pos count.
+    // Walls are tested through the scene's grid index when scene is loaded, otherwise one by one.
+    int nearestVisible(glm::vec2 pos, float maxDistance, bool withinRadius, const QList<Wall*>& walls, Scene* scene);
+
+    glm::vec2 position(int light);
+    float maxRadius; // largest radius of any light
+
+private:
+    QVector<glm::vec2> positions;
+    QVector<float> radii;
+    int gridSize;
+    float cellSize;
+    QVector<int> cellStart; // the lights in cell c are cellLights[cellStart[c]] up to cellLights[cellStart[c+1]]
+    QVector<int> cellLights;
+
+    int cellIndex(float coord);
+};
+
+#endif // LIGHTINDEX_H
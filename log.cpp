@@ -0,0 +1,233 @@
+#include "log.h"
+#include <thread>
+#include <chrono>
+#include <string.h>
+
+std::atomic<int> Logger::threshold(LOG_WARNING);
+
+namespace {
+
+struct Entry {
+    int length;
+    char text[LogMessage::MAX_LENGTH];
+};
+
+const unsigned int RING_SIZE = 1024; // lines per thread; must be a power of two
+
+// Single-producer single-consumer ring: only the owning thread moves head, only the drain thread moves tail
+struct Ring {
+    Entry entries[RING_SIZE];
+    std::atomic<unsigned int> head;
+    std::atomic<unsigned int> tail;
+    std::atomic<bool> owned; // cleared when the owning thread exits, so another thread can take the ring over
+    Ring* next;
+};
+
+std::atomic<Ring*> rings(0); // rings are only ever added to the front of this list, never removed
+std::atomic<FILE*> output(stdout);
+std::atomic<unsigned int> dropped(0); // lines lost because a ring was full
+
+Ring* acquireRing() {
+    // take over an empty ring from a thread that has exited
+    for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (r->head.load(std::memory_order_acquire) == r->tail.load(std::memory_order_acquire) &&
+                r->owned.compare_exchange_strong(expected, true)) {
+            return r;
+        }
+    }
+    Ring* ring = new Ring();
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->owned.store(true);
+    ring->next = rings.load(std::memory_order_relaxed);
+    while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release)) {}
+    return ring;
+}
+
+struct RingOwner {
+    Ring* ring;
+    RingOwner() : ring(0) {}
+    ~RingOwner() {
+        if (this->ring) {
+            this->ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+// writes out every line that is in a ring right now; returns how many there were
+int drain() {
+    FILE* out = output.load();
+    int written = 0;
+    for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+        unsigned int head = r->head.load(std::memory_order_acquire);
+        unsigned int tail = r->tail.load(std::memory_order_relaxed);
+        for (; tail != head; tail++) {
+            Entry& entry = r->entries[tail % RING_SIZE];
+            fwrite(entry.text, 1, entry.length, out);
+            fputc('\n', out);
+            written++;
+        }
+        r->tail.store(tail, std::memory_order_release);
+    }
+    unsigned int lost = dropped.exchange(0);
+    if (lost > 0) {
+        fprintf(out, "(%u log lines dropped)\n", lost);
+    }
+    if (written > 0 || lost > 0) {
+        fflush(out);
+    }
+    return written;
+}
+
+class Drainer
+{
+public:
+    Drainer() : stopping(false), thread(&Drainer::run, this) {}
+    ~Drainer() {
+        this->stopping.store(true);
+        this->thread.join();
+    }
+
+private:
+    std::atomic<bool> stopping;
+    std::thread thread;
+
+    void run() {
+        while (!this->stopping.load()) {
+            if (drain() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        drain();
+    }
+};
+
+// started by the first line that is logged
+Drainer& drainer() {
+    static Drainer instance;
+    return instance;
+}
+
+}
+
+void Logger::setLevel(LogLevel level) {
+    threshold.store(level);
+}
+
+void Logger::setOutput(FILE* file) {
+    flush();
+    output.store(file);
+}
+
+void Logger::flush() {
+    // every ring has to get to where its head is now
+    for (Ring* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+        unsigned int head = r->head.load(std::memory_order_acquire);
+        while ((int) (head - r->tail.load(std::memory_order_acquire)) > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void Logger::write(const char* text, int length) {
+    static thread_local RingOwner owner;
+    if (!owner.ring) {
+        drainer();
+        owner.ring = acquireRing();
+    }
+    Ring* ring = owner.ring;
+    unsigned int head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) == RING_SIZE) {
+        // the drain thread is behind; drop the line rather than wait
+        dropped.fetch_add(1);
+        return;
+    }
+    Entry& entry = ring->entries[head % RING_SIZE];
+    memcpy(entry.text, text, length);
+    entry.length = length;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+LogMessage::LogMessage(LogLevel level)
+{
+    this->length = 0;
+    if (level == LOG_WARNING) {
+        *this << "WARNING: ";
+    } else if (level == LOG_ERROR) {
+        *this << "ERROR: ";
+    }
+}
+
+LogMessage::~LogMessage() {
+    Logger::write(this->text, this->length);
+}
+
+void LogMessage::append(const char* data, size_t size) {
+    size_t room = MAX_LENGTH - this->length;
+    if (size > room) {
+        size = room;
+    }
+    memcpy(this->text + this->length, data, size);
+    this->length += size;
+}
+
+LogMessage& LogMessage::operator<<(const char* text) {
+    append(text, strlen(text));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(const QString& text) {
+    QByteArray utf8 = text.toUtf8();
+    append(utf8.constData(), utf8.size());
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(char c) {
+    append(&c, 1);
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(bool b) {
+    return *this << (b ? "true" : "false");
+}
+
+LogMessage& LogMessage::operator<<(int n) {
+    char buffer[16];
+    append(buffer, snprintf(buffer, sizeof(buffer), "%d", n));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(unsigned int n) {
+    char buffer[16];
+    append(buffer, snprintf(buffer, sizeof(buffer), "%u", n));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(long n) {
+    char buffer[24];
+    append(buffer, snprintf(buffer, sizeof(buffer), "%ld", n));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(unsigned long n) {
+    char buffer[24];
+    append(buffer, snprintf(buffer, sizeof(buffer), "%lu", n));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(float f) {
+    return *this << (double) f;
+}
+
+LogMessage& LogMessage::operator<<(double d) {
+    char buffer[32];
+    append(buffer, snprintf(buffer, sizeof(buffer), "%g", d));
+    return *this;
+}
+
+LogMessage& LogMessage::operator<<(glm::vec2 v) {
+    char buffer[48];
+    append(buffer, snprintf(buffer, sizeof(buffer), "(%g, %g)", v.x, v.y));
+    return *this;
+}
@@ -0,0 +1,72 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <sstream>
+#include <cstdio>
+#include <QString>
+#include <include/glm/glm.hpp>
+
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARNING, LOG_ERROR, LOG_OFF };
+
+// Usage: LOG(LOG_DEBUG) << "numMosqsToCatch " << n;
+// Each statement is one line. Lines are copied into a ring buffer owned by the calling thread and written out
+// by a background thread, so logging never blocks on the output. If the level is disabled the whole
+// statement (including building its arguments) costs one branch.
+#define LOG(level) if (!Logger::enabled(level)) {} else LogMessage(level)
+
+class Logger
+{
+public:
+    static bool enabled(LogLevel level) {
+        return level >= threshold.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level); // messages below level are dropped (LOG_WARNING by default)
+    static void setOutput(FILE* output); // stdout by default
+    static void flush(); // waits until every line logged so far has been written
+
+    static void write(const char* text, int length);
+
+private:
+    static std::atomic<int> threshold;
+};
+
+// Collects one line in a fixed buffer; it is handed to the Logger when the statement ends
+class LogMessage
+{
+public:
+    LogMessage(LogLevel level);
+    ~LogMessage();
+
+    LogMessage& operator<<(const char* text);
+    LogMessage& operator<<(const QString& text);
+    LogMessage& operator<<(char c);
+    LogMessage& operator<<(bool b);
+    LogMessage& operator<<(int n);
+    LogMessage& operator<<(unsigned int n);
+    LogMessage& operator<<(long n);
+    LogMessage& operator<<(unsigned long n);
+    LogMessage& operator<<(float f);
+    LogMessage& operator<<(double d);
+    LogMessage& operator<<(glm::vec2 v);
+
+    // anything else that can be written to an ostream (armadillo vectors, Nodes, ...)
+    template <typename T>
+    LogMessage& operator<<(const T& value) {
+        std::ostringstream stream;
+        stream << value;
+        std::string text = stream.str();
+        append(text.data(), text.size());
+        return *this;
+    }
+
+    static const int MAX_LENGTH = 240; // longer lines are cut off
+
+private:
+    int length;
+    char text[MAX_LENGTH];
+
+    void append(const char* data, size_t size);
+};
+
+#endif // LOG_H
@@ -1,17 +1,191 @@
 #include "window.h"
+#include "frameexporter.h"
+#include "metrics.h"
+#include "tuner.h"
+#include "allocprofile.h"
+#include "bench.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QSurfaceFormat>
+#include <QDir>
 #include <execinfo.h>
 #include <cxxabi.h>
+#include <stdio.h>
+#include <string.h>
+
+// Plays games without a window, optionally exporting every round as a frame
+static int runHeadless(QCommandLineParser& parser) {
+    MyPlayer* player = new MyPlayer();
+    if (parser.isSet("params") && !player->params.parse(parser.value("params"))) {
+        fprintf(stderr, "Could not parse --params %s\n", qPrintable(parser.value("params")));
+        delete player;
+        return 1;
+    }
+    player->usePlanner = parser.isSet("planner");
+    // one Board plays every game; initialize() reuses its memory
+    Board board(player);
+    Scene scene;
+    if (!scene.load(parser.value("layout"), board.boardSize, player->params)) {
+        fprintf(stderr, "Could not read %s\n", qPrintable(parser.value("layout")));
+        return 1;
+    }
+
+    int games = parser.value("games").toInt();
+    bool exporting = parser.isSet("export");
+    bool raw = parser.value("format") == "raw";
+    FrameExporter exporter;
+    exporter.size = parser.value("frame-size").toInt();
+    if (exporting && raw && !exporter.open(parser.value("export"), FrameExporter::RAW)) {
+        fprintf(stderr, "Could not open %s\n", qPrintable(parser.value("export")));
+        return 1;
+    }
+
+    bool profiling = parser.isSet("alloc-profile");
+    if (profiling && !AllocProfiler::compiledIn()) {
+        fprintf(stderr, "--alloc-profile needs a build with CONFIG+=alloc_profile\n");
+        return 1;
+    }
+    if (profiling && !AllocProfiler::open(parser.value("alloc-profile"))) {
+        fprintf(stderr, "Could not open %s\n", qPrintable(parser.value("alloc-profile")));
+        return 1;
+    }
+
+    MetricsRecorder metrics;
+    if (parser.isSet("metrics")) {
+        if (!metrics.open(parser.value("metrics"), board.numLights)) {
+            fprintf(stderr, "Could not open %s\n", qPrintable(parser.value("metrics")));
+            return 1;
+        }
+        board.metrics = &metrics;
+    }
+
+    board.setScene(&scene);
+    if (parser.isSet("rounds")) {
+        board.maxRounds = parser.value("rounds").toInt();
+    }
+    if (parser.isSet("mosquitoes")) {
+        board.numMosquitoes = parser.value("mosquitoes").toInt();
+        board.captureTarget = board.numMosquitoes;
+    }
+    board.hybrid = parser.isSet("hybrid");
+    board.maxSkip = parser.value("skip-rounds").toInt();
+    for (int g = 0; g < games; g++) {
+        if (parser.isSet("seed")) {
+            board.seed(parser.value("seed").toUInt() + g);
+        }
+        board.initialize();
+        metrics.beginGame();
+
+        if (exporting && !raw) {
+            // every game gets its own numbered PNG sequence
+            QString directory = QDir(parser.value("export")).filePath(QString("game_%1").arg(g, 4, 10, QChar('0')));
+            if (!exporter.open(directory, FrameExporter::PNG)) {
+                fprintf(stderr, "Could not create %s\n", qPrintable(directory));
+                return 1;
+            }
+        }
+        if (exporting) {
+            exporter.addFrame(&board);
+        }
+        while (!board.finished()) {
+            board.step();
+            if (exporting) {
+                exporter.addFrame(&board);
+            }
+        }
+        if (exporting && !raw) {
+            exporter.finish();
+        }
+        fprintf(stderr, "game %d: %d of %d mosquitoes eaten in %d rounds\n",
+                g, board.mosquitoesEaten, board.captureTarget, board.currRound);
+    }
+    exporter.finish();
+    metrics.close();
+    if (profiling) {
+        AllocProfiler::close();
+        AllocProfiler::report(stderr);
+    }
+    return 0;
+}
+
+static int runTuner(QCommandLineParser& parser) {
+    Tuner tuner;
+    tuner.layoutPath = parser.value("layout");
+    tuner.numConfigs = parser.value("tune-configs").toInt();
+    tuner.initialGames = parser.value("tune-games").toInt();
+    if (parser.isSet("rounds")) {
+        tuner.maxRounds = parser.value("rounds").toInt();
+    }
+    if (parser.isSet("seed")) {
+        tuner.seed = parser.value("seed").toUInt();
+    }
+    StrategyParams best = tuner.run(stderr);
+    // in the form --params takes
+    printf("%s\n", qPrintable(best.toString()));
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
 
     srand (static_cast <unsigned> (time(0)));
 
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0 || strcmp(argv[i], "--tune") == 0 || strcmp(argv[i], "--bench-sort") == 0) {
+            headless = true;
+        }
+    }
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        // frames are drawn into QImages, so no display (or GPU) is needed
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication app(argc, argv);
 
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mosquito Buzz Buzz");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("headless", "Play without a window."));
+    parser.addOption(QCommandLineOption("games", "Number of games to play headless.", "n", "1"));
+    parser.addOption(QCommandLineOption("rounds", "Maximum number of rounds per game.", "n"));
+    parser.addOption(QCommandLineOption("seed", "Seed of the first game; the following games use seed + 1, ...", "seed"));
+    parser.addOption(QCommandLineOption("layout", "Wall layout to play on.", "file", "wall_setup.txt"));
+    parser.addOption(QCommandLineOption("export", "Write every round as a frame: a directory of PNG sequences per game, or a raw stream file (- for stdout).", "path"));
+    parser.addOption(QCommandLineOption("format", "Frame format: png or raw.", "format", "png"));
+    parser.addOption(QCommandLineOption("frame-size", "Width and height of exported frames.", "pixels", "500"));
+    parser.addOption(QCommandLineOption("metrics", "Record a row of metrics for every round of every game into a columnar file.", "file"));
+    parser.addOption(QCommandLineOption("metrics-csv", "Print a file recorded with --metrics as CSV and exit.", "file"));
+    parser.addOption(QCommandLineOption("params", "Strategy parameters for headless games, as name=value,name=value (see --tune).", "params"));
+    parser.addOption(QCommandLineOption("planner", "Refine the light moves of headless games with look-ahead rollouts (slow with many mosquitoes)."));
+    parser.addOption(QCommandLineOption("tune", "Search the strategy parameters with successive halving and print the best ones."));
+    parser.addOption(QCommandLineOption("tune-configs", "Number of configurations the tuner starts with.", "n", "27"));
+    parser.addOption(QCommandLineOption("alloc-profile", "Count heap allocations per phase and round of headless games into a CSV file "
+                                        "(needs a build with CONFIG+=alloc_profile).", "file"));
+    parser.addOption(QCommandLineOption("tune-games", "Games every configuration plays before the first cut.", "n", "2"));
+    parser.addOption(QCommandLineOption("mosquitoes", "Number of mosquitoes in headless games.", "n"));
+    parser.addOption(QCommandLineOption("hybrid", "Simulate the mosquitoes far from the lights as a density field (for very large swarms)."));
+    parser.addOption(QCommandLineOption("skip-rounds", "Let mosquitoes far from everything walk up to this many rounds in one draw (0: off).", "n", "0"));
+    parser.addOption(QCommandLineOption("bench-sort", "Compare stepping with the mosquitoes in Z-order and in creation order, and exit."));
+    parser.addOption(QCommandLineOption("bench-mosquitoes", "Number of mosquitoes for --bench-sort.", "n", "1000000"));
+    parser.process(app);
+
+    if (parser.isSet("metrics-csv")) {
+        return MetricsRecorder::exportCsv(parser.value("metrics-csv"), stdout) ? 0 : 1;
+    }
+
+    if (parser.isSet("bench-sort")) {
+        int rounds = parser.isSet("rounds") ? parser.value("rounds").toInt() : 20;
+        return runSortBenchmark(parser.value("bench-mosquitoes").toInt(), rounds, stdout);
+    }
+    if (parser.isSet("tune")) {
+        return runTuner(parser);
+    }
+    if (parser.isSet("headless")) {
+        return runHeadless(parser);
+    }
+
     QSurfaceFormat fmt;
     fmt.setSamples(4);
     QSurfaceFormat::setDefaultFormat(fmt);
@@ -1,6 +1,9 @@
 #include "light.h"
 #include "matrix.h"
 #include "wall.h"
+#include "scene.h"
+#include "lightindex.h"
+#include "allocprofile.h"
 #include <armadillo>
 #include <set>
 #include <algorithm>
@@ -10,10 +13,7 @@
 using namespace std;
 using namespace arma;
 
-float BOARD_SIZE = 500;
-float T_WIDTH = 20;
-float WALL_INSET = 10;
-float NODE_OFFSET = 5;//20;
+const float BOARD_SIZE = 500;
 
 bool operator==(Node lhs, Node rhs) {
     double e = .01;
@@ -38,23 +38,9 @@ glm::vec2 setLength(glm::vec2 v, float length) {
 }
 
 bool withinLight(glm::vec2 mosquitoPos,
-                 QList<Light*> lights,
-                 QList<Wall*> walls) {
-    for (Light* light : lights) {
-        bool wallInWay = false;
-        for (Wall* wall : walls) {
-            if (wall->isInvalidMove(mosquitoPos, light->getPosition())) {
-                wallInWay = true;
-            }
-        }
-        glm::vec2 lightPos = light->getPosition();
-        double distance =  sqrt(pow(mosquitoPos.x - lightPos.x, 2)
-                              + pow(mosquitoPos.y - lightPos.y, 2));
-        if (distance < light->radius && !wallInWay) {
-            return true;
-        }
-    }
-    return false;
+                 LightIndex& lights,
+                 QList<Wall*>& walls) {
+    return lights.nearestVisible(mosquitoPos, lights.maxRadius, true, walls, 0) >= 0;
 }
 
 vec glmToArma(glm::vec2 v) {
@@ -72,12 +58,15 @@ glm::vec2 nodeToGlm(Node n) {
 mat getCoords(QVector<QVector<int> >* board,
               QList<Light*> lights,
               QList<Wall*> walls) {
+    ALLOC_SCOPE("getCoords");
     vector <double> coords;
     int numMosqs = 0;
+    LightIndex index;
+    index.rebuild(lights, BOARD_SIZE);
     for (int i = 0; i < board->size(); i++) {
         for (int j = 0; j < board->at(i).size(); j++) {
             if ((*board)[i][j] == 1) {
-                if (!withinLight(glm::vec2({i, j}), lights, walls)) {
+                if (!withinLight(glm::vec2({i, j}), index, walls)) {
                     numMosqs++;
                     for (auto k: {i, j}) {
                         coords.push_back((float) k);
@@ -93,6 +82,7 @@ mat getCoords(QVector<QVector<int> >* board,
 }
 
 mat getCentroids(mat coords, int num) {
+    ALLOC_SCOPE("kmeans");
     mat centroids;
     kmeans(centroids, coords, num,
            random_spread, // initializer
@@ -130,11 +120,11 @@ glm::vec2 extend(glm::vec2 near, glm::vec2 far, float offsetLength) {
     return near + offset;
 }
 
-graph graphBetween(vec here, vec there, QList<Wall*> walls) {
-    vector<Node> nodes = {Node(here), Node(there)};
+vector<Node> getWallNodes(QList<Wall*> walls, const StrategyParams& params) {
+    vector<Node> nodes;
     for (Wall* wall : walls) {
-        Node n1(extend(wall->point1 , wall->point2, NODE_OFFSET));
-        Node n2(extend(wall->point2 , wall->point1, NODE_OFFSET));
+        Node n1(extend(wall->point1 , wall->point2, params.nodeOffset));
+        Node n2(extend(wall->point2 , wall->point1, params.nodeOffset));
         if (inBounds(n1)) {
             nodes.push_back(n1);
         }
@@ -142,20 +132,30 @@ graph graphBetween(vec here, vec there, QList<Wall*> walls) {
             nodes.push_back(n2);
         }
     }
+    return nodes;
+}
+
+bool straightShot(Node from, Node to, QList<Wall*> walls) {
+    for (Wall* wall : walls) {
+        if (wall->isInvalidMove(from.glm(), to.glm())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+graph graphBetween(vec here, vec there, QList<Wall*> walls, const StrategyParams& params) {
+    vector<Node> nodes = {Node(here), Node(there)};
+    for (Node n : getWallNodes(walls, params)) {
+        nodes.push_back(n);
+    }
     graph neighbors;
     for (Node n : nodes) {
         neighbors[n] = {};
     }
     for (int i = 0; i < int(nodes.size()); i++) {
         for (int j = 0; j < int(nodes.size()); j++) {
-            bool straightShot = true;
-            for (Wall* wall : walls) {
-                if (wall->isInvalidMove(nodes[i].glm(), nodes[j].glm())) {
-
-                    straightShot = false;
-                }
-            }
-            if (straightShot) {
+            if (straightShot(nodes[i], nodes[j], walls)) {
                 if (nodes[i] != nodes[j]) {
                     neighbors[nodes[i]].push_back(nodes[j]);
                 }
@@ -165,13 +165,59 @@ graph graphBetween(vec here, vec there, QList<Wall*> walls) {
     return neighbors;
 }
 
+graph graphBetween(vec here, vec there, QList<Wall*> walls, Scene* scene, const StrategyParams& params) {
+    ALLOC_SCOPE("graphBetween");
+    if (!scene || !scene->isLoaded()) {
+        return graphBetween(here, there, walls, params);
+    }
+    // the edges between wall corners come precomputed with the scene,
+    // so only here and there need to be connected to the rest of the graph
+    graph neighbors;
+    for (int n = 0; n < scene->numNodes; n++) {
+        vector<Node>& adjacent = neighbors[Node(scene->nodes[n])];
+        for (quint32 e = scene->edgeStart[n]; e < scene->edgeStart[n+1]; e++) {
+            adjacent.push_back(Node(scene->nodes[scene->edges[e]]));
+        }
+    }
+    Node hereNode(here), thereNode(there);
+    neighbors[hereNode];
+    neighbors[thereNode];
+    for (int n = 0; n < scene->numNodes; n++) {
+        Node corner(scene->nodes[n]);
+        for (Node end : {hereNode, thereNode}) {
+            if (end != corner && straightShot(end, corner, walls)) {
+                neighbors[end].push_back(corner);
+                neighbors[corner].push_back(end);
+            }
+        }
+    }
+    if (hereNode != thereNode && straightShot(hereNode, thereNode, walls)) {
+        neighbors[hereNode].push_back(thereNode);
+        neighbors[thereNode].push_back(hereNode);
+    }
+    return neighbors;
+}
 
-
-Wall getTWall(glm::vec2 near, glm::vec2 far) {
-    vec params = getLineParams(glmToArma(near), glmToArma(far));
+Wall getTWall(glm::vec2 near, glm::vec2 far, const StrategyParams& params) {
+    vec lineParams = getLineParams(glmToArma(near), glmToArma(far));
     double a = getLineParams(glmToArma(near), glmToArma(far))[0];
-    glm::vec2 offset = setLength(glm::vec2(a, -1), T_WIDTH);
-    glm::vec2 inset = setLength(far - near, WALL_INSET);
+    glm::vec2 offset = setLength(glm::vec2(a, -1), params.tWidth);
+    glm::vec2 inset = setLength(far - near, params.wallInset);
     near = near + inset;
     return Wall(near + offset, near - offset);
 }
+
+Wall extendWall(Wall w, const StrategyParams& params) {
+    return Wall(extend(w.point1, w.point2, params.wallOffset),
+                extend(w.point2, w.point1, params.wallOffset));
+}
+
+vector<Wall> getPlayerWalls(QList<Wall*> walls, const StrategyParams& params) {
+    vector<Wall> result;
+    for (Wall* wall : walls) {
+        result.push_back(getTWall(wall->point1, wall->point2, params));
+        result.push_back(getTWall(wall->point2, wall->point1, params));
+        result.push_back(extendWall(*wall, params));
+    }
+    return result;
+}
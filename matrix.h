@@ -5,6 +5,9 @@
 #include <QDebug>
 #include "light.h"
 #include "wall.h"
+#include "strategyparams.h"
+
+class Scene;
 
 using namespace std;
 using namespace arma;
@@ -28,8 +31,13 @@ bool operator<(Node lhs, Node rhs);
 mat getCoords(QVector<QVector<int> >* board, QList<Light*> lights, QList<Wall*> walls);
 mat getCentroids(mat coords, int num);
 vector<vec> getDistVecs(mat centroids, QList<Light*> lights, bool replace_centroids);
-graph graphBetween(vec here, vec there, QList<Wall*> walls);
-Wall getTWall(glm::vec2 w1, glm::vec2 w2);
+graph graphBetween(vec here, vec there, QList<Wall*> walls, const StrategyParams& params);
+graph graphBetween(vec here, vec there, QList<Wall*> walls, Scene* scene, const StrategyParams& params); // reuses the static part of the graph stored in the scene
+vector<Node> getWallNodes(QList<Wall*> walls, const StrategyParams& params);
+bool straightShot(Node from, Node to, QList<Wall*> walls);
+Wall getTWall(glm::vec2 w1, glm::vec2 w2, const StrategyParams& params);
+Wall extendWall(Wall w, const StrategyParams& params);
+vector<Wall> getPlayerWalls(QList<Wall*> walls, const StrategyParams& params); // the T-walls and extended walls the Player plans around
 glm::vec2 setLength(glm::vec2 v, float length);
 ostream& operator<<(ostream& os, const Node& node);
 glm::vec2 extend(glm::vec2 near, glm::vec2 far, float offset);
@@ -0,0 +1,235 @@
+#include "metrics.h"
+#include "board.h"
+#include <QtEndian>
+#include <string.h>
+#include <type_traits>
+
+static const char METRICS_MAGIC[4] = {'B', 'Z', 'M', 'T'};
+static const quint32 METRICS_VERSION = 1;
+
+static int columnWidth(char type) {
+    return type == 'q' ? 8 : 4;
+}
+
+// every value in the file is stored little endian, whatever the host's byte order is; floats go through
+// the unsigned integer of the same size
+template <typename T>
+static void storeLittleEndian(char* out, T value) {
+    typedef typename std::conditional<sizeof(T) == 8, quint64, quint32>::type Bits;
+    Bits bits;
+    memcpy(&bits, &value, sizeof(T));
+    bits = qToLittleEndian(bits);
+    memcpy(out, &bits, sizeof(T));
+}
+
+template <typename T>
+static T loadLittleEndian(const char* in) {
+    typedef typename std::conditional<sizeof(T) == 8, quint64, quint32>::type Bits;
+    Bits bits;
+    memcpy(&bits, in, sizeof(T));
+    bits = qFromLittleEndian(bits);
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+static void writeU32(QFile& file, quint32 value) {
+    char bytes[4];
+    storeLittleEndian(bytes, value);
+    file.write(bytes, 4);
+}
+
+static bool readU32(QFile& file, quint32* value) {
+    char bytes[4];
+    if (file.read(bytes, 4) != 4) {
+        return false;
+    }
+    *value = loadLittleEndian<quint32>(bytes);
+    return true;
+}
+
+MetricsRecorder::MetricsRecorder()
+{
+    this->blockRows = 4096;
+    this->rows = 0;
+    this->game = 0;
+    this->numLights = 0;
+}
+
+MetricsRecorder::~MetricsRecorder() {
+    close();
+}
+
+void MetricsRecorder::addColumn(char type, const QString& name) {
+    Column column;
+    column.type = type;
+    column.name = name;
+    column.values.reserve(this->blockRows * columnWidth(type));
+    this->columns.push_back(column);
+}
+
+bool MetricsRecorder::open(const QString& path, int numLights) {
+    close();
+    this->file.setFileName(path);
+    if (!this->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    this->numLights = numLights;
+    this->rows = 0;
+    this->game = -1;
+    this->lastPositions.assign(numLights, glm::vec2(0.0f, 0.0f));
+    this->columns.clear();
+    addColumn('i', "game");
+    addColumn('i', "round");
+    addColumn('i', "eaten");
+    addColumn('i', "caught");
+    addColumn('i', "free");
+    for (int l = 0; l < numLights; l++) {
+        QString light = "light" + QString::number(l);
+        addColumn('f', light + "_x");
+        addColumn('f', light + "_y");
+        addColumn('f', light + "_vx");
+        addColumn('f', light + "_vy");
+    }
+    addColumn('q', "player_ns");
+    addColumn('q', "step_ns");
+
+    quint32 numColumns = this->columns.size();
+    this->file.write(METRICS_MAGIC, 4);
+    writeU32(this->file, METRICS_VERSION);
+    writeU32(this->file, numColumns);
+    for (const Column& column : this->columns) {
+        QByteArray name = column.name.toUtf8();
+        quint8 length = name.size();
+        this->file.write(&column.type, 1);
+        this->file.write(reinterpret_cast<const char*>(&length), 1);
+        this->file.write(name.constData(), length);
+    }
+    return true;
+}
+
+void MetricsRecorder::close() {
+    if (!this->file.isOpen()) {
+        return;
+    }
+    writeBlock();
+    this->file.close();
+}
+
+void MetricsRecorder::beginGame() {
+    this->game++;
+}
+
+template <typename T>
+void MetricsRecorder::append(int column, T value) {
+    std::vector<char>& values = this->columns[column].values;
+    size_t end = values.size();
+    values.resize(end + sizeof(T));
+    storeLittleEndian(&values[end], value);
+}
+
+void MetricsRecorder::record(Board* board) {
+    if (!this->file.isOpen()) {
+        return;
+    }
+    qint32 eaten = 0;
+    qint32 caught = 0;
+    for (int i = 0; i < board->mosquitoes.length(); i++) {
+        if (board->mosquitoes.at(i)->isEaten) {
+            eaten++;
+        } else if (board->mosquitoes.at(i)->isCaught) {
+            caught++;
+        }
+    }
+
+    int c = 0;
+    append<qint32>(c++, glm::max(this->game, 0));
+    append<qint32>(c++, board->currRound);
+    append<qint32>(c++, eaten);
+    append<qint32>(c++, caught);
+    // in hybrid mode most of the free mosquitoes are in the field rather than the list
+    append<qint32>(c++, board->numMosquitoes - eaten - caught);
+    for (int l = 0; l < this->numLights; l++) {
+        glm::vec2 position = l < board->lights.length() ? board->lights.at(l)->getPosition() : glm::vec2(0.0f, 0.0f);
+        // the first round of a game has no previous position
+        glm::vec2 velocity = board->currRound > 1 ? position - this->lastPositions[l] : glm::vec2(0.0f, 0.0f);
+        this->lastPositions[l] = position;
+        append<float>(c++, position.x);
+        append<float>(c++, position.y);
+        append<float>(c++, velocity.x);
+        append<float>(c++, velocity.y);
+    }
+    append<qint64>(c++, board->playerTime);
+    append<qint64>(c++, board->stepTime);
+
+    this->rows++;
+    if (this->rows >= this->blockRows) {
+        writeBlock();
+    }
+}
+
+void MetricsRecorder::writeBlock() {
+    if (this->rows == 0) {
+        return;
+    }
+    writeU32(this->file, this->rows);
+    for (Column& column : this->columns) {
+        this->file.write(column.values.data(), column.values.size());
+        column.values.clear(); // keeps the capacity for the next block
+    }
+    this->rows = 0;
+}
+
+bool MetricsRecorder::exportCsv(const QString& path, FILE* out) {
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    char magic[4];
+    quint32 version = 0;
+    quint32 numColumns = 0;
+    if (in.read(magic, 4) != 4 || memcmp(magic, METRICS_MAGIC, 4) != 0 ||
+            !readU32(in, &version) || version != METRICS_VERSION || !readU32(in, &numColumns)) {
+        return false;
+    }
+
+    std::vector<char> types(numColumns);
+    for (quint32 c = 0; c < numColumns; c++) {
+        quint8 length = 0;
+        char name[256];
+        in.read(&types[c], 1);
+        in.read(reinterpret_cast<char*>(&length), 1);
+        in.read(name, length);
+        fprintf(out, "%s%.*s", c > 0 ? "," : "", (int) length, name);
+    }
+    fprintf(out, "\n");
+
+    quint32 rows = 0;
+    std::vector<QByteArray> block(numColumns);
+    while (readU32(in, &rows)) {
+        for (quint32 c = 0; c < numColumns; c++) {
+            block[c] = in.read((qint64) rows * columnWidth(types[c]));
+            if (block[c].size() != (int) rows * columnWidth(types[c])) {
+                return false;
+            }
+        }
+        for (quint32 r = 0; r < rows; r++) {
+            for (quint32 c = 0; c < numColumns; c++) {
+                const char* value = block[c].constData() + r * columnWidth(types[c]);
+                if (c > 0) {
+                    fputc(',', out);
+                }
+                if (types[c] == 'i') {
+                    fprintf(out, "%d", loadLittleEndian<qint32>(value));
+                } else if (types[c] == 'f') {
+                    fprintf(out, "%g", loadLittleEndian<float>(value));
+                } else {
+                    fprintf(out, "%lld", (long long) loadLittleEndian<qint64>(value));
+                }
+            }
+            fputc('\n', out);
+        }
+    }
+    return true;
+}
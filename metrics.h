@@ -0,0 +1,53 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+#include <stdio.h>
+#include <include/glm/glm.hpp>
+
+class Board;
+
+// Records one row per Board::step() into a columnar binary file. Rows are collected per column in memory
+// and written as blocks of blockRows rows, where each column's values are stored next to each other.
+//
+// File layout (little endian): "BZMT", version (u32), number of columns (u32), then per column its type
+// ('i' int32, 'f' float32, 'q' int64, as a u8), the length of its name (u8) and the name. Then blocks:
+// number of rows (u32) followed by every column's values for those rows.
+class MetricsRecorder
+{
+public:
+    MetricsRecorder();
+    ~MetricsRecorder();
+
+    int blockRows; // rows collected before a block is written
+
+    bool open(const QString& path, int numLights); // the number of lights fixes the columns
+    void close(); // writes the last block
+    void beginGame(); // rows after this get the next game number (the first game is 0)
+    void record(Board* board); // appends a row for the Board's current round (called by Board::step)
+
+    static bool exportCsv(const QString& path, FILE* out); // writes a recorded file as CSV with a header line
+
+private:
+    struct Column {
+        char type;
+        QString name;
+        std::vector<char> values;
+    };
+
+    QFile file;
+    std::vector<Column> columns;
+    int rows; // rows in the current block
+    int game;
+    int numLights;
+    std::vector<glm::vec2> lastPositions; // to work out the light velocities
+
+    void addColumn(char type, const QString& name);
+    void writeBlock();
+    template <typename T>
+    void append(int column, T value);
+};
+
+#endif // METRICS_H
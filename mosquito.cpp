@@ -4,10 +4,11 @@ Mosquito::Mosquito()
 {
     this->isCaught = false;
     this->isEaten = false;
+    this->wakeRound = 0;
 }
 
-float generateRandomAngle() {
-    float result = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX/(2*M_PI)));
+float generateRandomAngle(std::mt19937& random) {
+    float result = std::uniform_real_distribution<float>(0.0f, 2*M_PI)(random);
     return result;
 }
 
@@ -26,12 +27,12 @@ float generateAngle(glm::vec2 nearestLightPos, glm::vec2 mosquitoPosition) {
     }
 }
 
-glm::vec2 Mosquito::calculateNextMove(glm::vec2 nearestLightPos) {
+glm::vec2 Mosquito::calculateNextMove(glm::vec2 nearestLightPos, std::mt19937& random) {
     if (isCaught) {
         glm::vec2 dir = nearestLightPos - this->position;
         glm::vec2 newPos = this->position + 0.01f*dir;
-        float random = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX/(60)));
-        float randomAngle = generateAngle(nearestLightPos, this->position) - 30 + random;
+        float spread = std::uniform_real_distribution<float>(0.0f, 60.0f)(random);
+        float randomAngle = generateAngle(nearestLightPos, this->position) - 30 + spread;
         float deltax = 2.0f * cos(randomAngle);
         float deltay = 2.0f * sin(randomAngle);
         float newx = newPos.x + deltax;
@@ -39,7 +40,7 @@ glm::vec2 Mosquito::calculateNextMove(glm::vec2 nearestLightPos) {
 
         return glm::vec2(newx, newy);
     } else {
-        float randomAngle = generateRandomAngle();
+        float randomAngle = generateRandomAngle(random);
         float deltax = 2.0f * cos(randomAngle);
         float deltay = 2.0f * sin(randomAngle);
         float newx = this->position.x + deltax;
@@ -49,6 +50,30 @@ glm::vec2 Mosquito::calculateNextMove(glm::vec2 nearestLightPos) {
     }
 }
 
+// walks at least this long are drawn from the normal distribution; shorter ones step by step
+static const int GAUSSIAN_WALK_STEPS = 8;
+
+glm::vec2 Mosquito::calculateWalk(int steps, std::mt19937& random) {
+    glm::vec2 displacement(0.0f, 0.0f);
+    if (steps < GAUSSIAN_WALK_STEPS) {
+        for (int s = 0; s < steps; s++) {
+            float randomAngle = generateRandomAngle(random);
+            displacement += glm::vec2(2.0f * cos(randomAngle), -2.0f * sin(randomAngle));
+        }
+        return this->position + displacement;
+    }
+    // a step of length 2 in a random direction has a variance of 2 along each axis and the steps are
+    // independent, so after many steps each axis is close to normal with variance 2 * steps
+    std::normal_distribution<float> axis(0.0f, sqrt(2.0f * steps));
+    displacement = glm::vec2(axis(random), axis(random));
+    // the walk can't get further than all its steps in a line
+    float length = glm::length(displacement);
+    if (length > 2.0f * steps) {
+        displacement *= 2.0f * steps / length;
+    }
+    return this->position + displacement;
+}
+
 void Mosquito::move(glm::vec2 nextMove) {
     this->position = nextMove;
 }
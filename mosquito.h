@@ -3,6 +3,7 @@
 
 #include <include/glm/glm.hpp>
 #include "math.h"
+#include <random>
 
 class Mosquito
 {
@@ -12,7 +13,9 @@ public:
     glm::vec2 position;
     bool isCaught; // flipped if the mosquito is caught by a light
     bool isEaten; // flipped if the mosquito has been eaten by the frog
-    glm::vec2 calculateNextMove(glm::vec2 nearestLightPos);
+    int wakeRound; // a mosquito that has walked several rounds ahead in one go doesn't move again before this round (see Board::maxSkip)
+    glm::vec2 calculateNextMove(glm::vec2 nearestLightPos, std::mt19937& random); // random is the Board's random number generator
+    glm::vec2 calculateWalk(int steps, std::mt19937& random); // where steps uncaught moves take it, drawn at once
     void move(glm::vec2 nextMove);
 };
 
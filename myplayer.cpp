@@ -1,5 +1,9 @@
 #include "myplayer.h"
 #include "matrix.h"
+#include "scene.h"
+#include "log.h"
+#include "taskpool.h"
+#include "allocprofile.h"
 #include <armadillo>
 #include <QDebug>
 #include <math.h>
@@ -10,22 +14,10 @@
 using namespace std;
 using namespace arma;
 
+const float PATH_TOLERANCE = 10; // how far a light's target can move before its path is planned again
+const float WAYPOINT_REACHED = 2; // how close a light has to get to a waypoint before it heads for the next one
 
-int roundNum = 0;
-int numLights = 4;
-mat centroids;
-vector <vec> velocities;
-vec FROG_POS = {250, 250};
-vector<vec> POSITIONS = {vec({70, 70}),
-                         vec({430, 70}),
-                         vec({430, 430}),
-                         vec({70, 430})};
 
-float SMOOTHING = 10;
-float WALL_OFFSET = 40;
-int START_HEAT_SEEKING = 300;
-bool DEBUG = false;
-vector<Wall> newWalls;
 
 //struct less<vec>{
 //   bool operator() (const vec& lhs, const vec& rhs) const {
@@ -63,6 +55,7 @@ Node nextDestination(vector<Node> path) {
 }
 
 vector<Node> runDijkstra(Node currentPosition, Node destination, graph neighbors) {
+   ALLOC_SCOPE("runDijkstra");
    map<Node, double> distances;
    vector<Node> active;
    map<Node, vector<Node>> paths;
@@ -95,8 +88,8 @@ vector<Node> runDijkstra(Node currentPosition, Node destination, graph neighbors
 }
 
 
-double getTotalDistance(vec coordinate1, vec coordinate2, QList<Wall*> walls) {
-    graph g = graphBetween(coordinate1, coordinate2, walls);
+double getTotalDistance(vec coordinate1, vec coordinate2, QList<Wall*> walls, const StrategyParams& params) {
+    graph g = graphBetween(coordinate1, coordinate2, walls, params);
     double totalDistance = 0;
     Node vertex1(coordinate1), vertex2(coordinate2);
     vector<Node> path = runDijkstra(vertex1, vertex2, g);
@@ -112,52 +105,72 @@ double getTotalDistance(vec coordinate1, vec coordinate2, QList<Wall*> walls) {
 }
 
 
-int  k = 1;
-
-vec getDelta(Light* light, vec destination, QList<Wall*> walls) {
+vec MyPlayer::getDelta(Light* light, vec destination) {
     vec lightPos = glmToArma(light->getPosition());
-    graph g = graphBetween(lightPos, destination, walls);
+    glm::vec2 position = light->getPosition();
+    glm::vec2 target = armaToGlm(destination);
+    int index = this->lights.indexOf(light);
+    PathCache& cache = this->paths[index]; // getDeltas has made room for every light
+
+    if (cache.valid && glm::length(target - cache.target) <= PATH_TOLERANCE) {
+        // the light is still heading for the same place: move on to the next waypoint once this one is reached
+        cache.waypoints.back() = target;
+        while (cache.next < int(cache.waypoints.size()) - 1 &&
+               glm::length(cache.waypoints[cache.next] - position) < WAYPOINT_REACHED) {
+            cache.next++;
+        }
+        if (straightShot(Node(position), Node(cache.waypoints[cache.next]), this->walls)) {
+            glm::vec2 toWaypoint = cache.waypoints[cache.next] - position;
+            if (glm::length(toWaypoint) > 0.0f) {
+                LOG(LOG_DEBUG) << "light " << index << " follows its cached path to " << cache.waypoints[cache.next];
+                return glmToArma(glm::normalize(toWaypoint));
+            }
+        }
+    }
+
+    graph g = graphBetween(lightPos, destination, this->walls, this->scene, this->params);
     vector<Node> path = runDijkstra(Node(lightPos), Node(destination), g);
     vec nextDest = static_cast<vec>(nextDestination(path));
     vec delta = normalise(nextDest - lightPos);
-    if (DEBUG) {
-        cout << "lightPos" << endl;
-        cout << lightPos << endl;
-        cout << endl << "graph" << endl;
+
+    cache.valid = true;
+    cache.target = target;
+    cache.waypoints.clear();
+    for (int i = path.size() > 1 ? 1 : 0; i < int(path.size()); i++) {
+        cache.waypoints.push_back(path[i].glm());
+    }
+    cache.next = 0;
+
+    if (Logger::enabled(LOG_DEBUG)) {
+        int k = index;
+        LOG(LOG_DEBUG) << "lightPos " << lightPos[0] << " " << lightPos[1];
+        LOG(LOG_DEBUG) << "graph";
         for (Node n : g[Node(lightPos)]) {
-            cout << "-" << n << endl;
+            LOG(LOG_DEBUG) << "-" << n[0] << " " << n[1];
         }
-        cout << endl << "path" << endl;
+        LOG(LOG_DEBUG) << "path";
         for (Node n : path) {
-            cout << n << endl;
+            LOG(LOG_DEBUG) << n[0] << " " << n[1];
         }
-        cout << "end path" << endl;
-        cout << "Light pos " <<  k << " " << lightPos[0] << endl;
-        cout << "Light pos " <<  k << " " << lightPos[1] << endl;
-        cout << "next dest " <<  k << " " << nextDestination(path)[0] << endl;
-        cout << "next dest " <<  k << " " << nextDestination(path)[1] << endl;
-        cout << "dest " <<  k << " " << destination[0] << endl;
-        cout << "dest " <<  k << " " << destination[1] << endl;
-        cout << "delta " <<  k << " " << delta[0] << endl;
-        cout << "delta " <<  k << " " << delta[1] << endl;
-        k++;
-        if (k > 4) {k = 1;}
+        LOG(LOG_DEBUG) << "end path";
+        LOG(LOG_DEBUG) << "Light pos " <<  k << " " << lightPos[0] << " " << lightPos[1];
+        LOG(LOG_DEBUG) << "next dest " <<  k << " " << nextDestination(path)[0] << " " << nextDestination(path)[1];
+        LOG(LOG_DEBUG) << "dest " <<  k << " " << destination[0] << " " << destination[1];
+        LOG(LOG_DEBUG) << "delta " <<  k << " " << delta[0] << " " << delta[1];
     }
     return delta;
 }
 
-vector<vec> getDistVecs(mat centroids,
-                        QList<Light*> lights,
-                        bool replace_centroids,
-                        QList<Wall*> walls) {
-    vector<vec> deltas;
+vector<vec> MyPlayer::getDistVecs(mat centroids,
+                                  QList<Light*> lights,
+                                  bool replace_centroids) {
     vector<vec> available;
     centroids.each_col([&](vec& centroidPos){
         available.push_back(centroidPos);
     });
-    int i = 0;
+    // the lights pick their centroids one after another (cheap), then plan their paths in parallel
+    vector<vec> targets;
     for (Light* light : lights) {
-        i++;
         // convert glm::vec to vec
         vec lightPos = glmToArma(light->getPosition());
 
@@ -169,18 +182,31 @@ vector<vec> getDistVecs(mat centroids,
                 double toC2 = getDistance(Node(lightPos), Node(c2));
                 return toC1 < toC2;
               });
-        vec delta = getDelta(light, *closestCentroid, walls);
-        deltas.push_back(delta);
+        targets.push_back(*closestCentroid);
         if (!replace_centroids) {
             available.erase(closestCentroid );
         }
     }
+    return getDeltas(lights, targets);
+}
+
+vector<vec> MyPlayer::getDeltas(QList<Light*> lights, vector<vec> destinations) {
+    // getDelta only touches its own light's path cache, so the cache must have room for every light first
+    if (this->paths.size() < size_t(this->lights.size())) {
+        this->paths.resize(this->lights.size());
+    }
+    vector<vec> deltas(lights.size());
+    TaskPool::shared()->parallelFor(lights.size(), [&](int i) {
+        deltas[i] = getDelta(lights.at(i), destinations[i]);
+    });
     return deltas;
 }
 
 MyPlayer::MyPlayer()
 {
     this->playerName = "My Player";
+    this->usePlanner = false;
+    this->roundNum = 0;
 }
 
 
@@ -196,16 +222,9 @@ glm::vec2 MyPlayer::initializeFrog(QVector<QVector<int> >* board) {
      * This places the frog in the center.
      * But you can place it anywhere you like!
      */
-    return armaToGlm(FROG_POS);
+    return this->params.frogPosition;
 }
 
-Wall extendWall(Wall w) {
-    return Wall(extend(w.point1, w.point2, WALL_OFFSET),
-                extend(w.point2, w.point1, WALL_OFFSET));
-}
-
-
-
 /*
  * Thisd method is called once at the start of the game.
  * You should set the initial position of each of the four lights.
@@ -245,73 +264,77 @@ void MyPlayer::initializeLights(QVector<QVector<int> >* board) {
       QColor(255, 0, 255)
     };
 
+    this->roundNum = 0;
+    this->velocities.clear();
+    this->paths.clear();
+
     for (int i = 0; i < this->lights.size(); i++) {
         Light* light = this->lights.at(i);
-        light->trailColor = colors[i];
+        light->trailColor = colors[i % colors.size()];
 
         // position lights at centroids
-        vec pos = POSITIONS[i];
-        light->setInitialPosition(pos[0], pos[1]);
+        glm::vec2 pos = this->params.positions.at(i % this->params.positions.size());
+        light->setInitialPosition(pos.x, pos.y);
 
-        velocities.push_back(vec({0, 0}));
+        this->velocities.push_back(vec({0, 0}));
     }
 
-    for (Wall* wall : this->walls) {
-        Wall t1 = getTWall(wall->point1, wall->point2);
-        Wall t2 = getTWall(wall->point2, wall->point1);
-        newWalls.push_back(t1);
-        newWalls.push_back(t2);
-        newWalls.push_back(extendWall(*wall));
-    }
-    this->walls.clear();
-    cout << "newWalls size " << newWalls.size() << endl;
-    for (int i = 0; i < int(newWalls.size()) ; i++) {
-        this->walls.push_back(&newWalls[i]);
+    // keep the real walls around for the planner's simulations
+    this->boardWalls = this->walls;
+    if (this->scene && this->scene->isLoaded()) {
+        // the T-walls and extended walls were derived when the layout was compiled
+        this->walls = this->scene->playerWalls();
+    } else {
+        // derive them into storage owned by this player; the pointers stay valid until the next game
+        this->derivedWalls = getPlayerWalls(this->walls, this->params);
+        this->walls.clear();
+        for (int i = 0; i < int(this->derivedWalls.size()) ; i++) {
+            this->walls.push_back(&this->derivedWalls[i]);
+        }
     }
-    cout << "walls size " << this->walls.size() << endl;
+    LOG(LOG_DEBUG) << "walls size " << this->walls.size();
 }
 
 /*
  * This method is called once per "step" in the simulation.
- * You can change the position of each Light by calling its moveTo method with the new x/y coordinate.
+ * It returns how far each Light should move, in the order of this->lights.
  * You may not, however, move a Light by more than one unit, and you may not move it through a wall!
  * The parameter specifies the number of mosquitoes at board->at(x).at(y)
  * You can access the walls through this object's "walls" field, which is a vector of Wall*
  */
-void MyPlayer::updateLights(QVector<QVector<int> >* board) {
+QVector<glm::vec2> MyPlayer::updateLights(QVector<QVector<int> >* board) {
 
-    roundNum++;
+    this->roundNum++;
     // coordinates of mosquitos outside light
     mat coords = getCoords(board, this->lights, this->walls);
     vector<vec> deltas;
     int numMosqsToCatch = size(coords)[1];
-    int numMosqsToLeave = 50;
+    int numMosqsToLeave = this->params.mosquitoesToLeave;
 
-    cout << "numMosqsToCatch " << numMosqsToCatch << endl;
+    LOG(LOG_DEBUG) << "numMosqsToCatch " << numMosqsToCatch;
 
-    float acceleration = 1 / (SMOOTHING * cbrt(max(numMosqsToCatch - numMosqsToLeave, 0)) + 1);
+    float acceleration = 1 / (this->params.smoothing * cbrt(max(numMosqsToCatch - numMosqsToLeave, 0)) + 1);
     if (numMosqsToCatch < numMosqsToLeave) {
 //    if (true) {
 
-        centroids = FROG_POS; // go to the frog
+        centroids = glmToArma(this->params.frogPosition); // go to the frog
         deltas = getDistVecs(centroids, this->lights,
-                                           true, // more than one light per centroid
-                                           this->walls);
+                                           true); // more than one light per centroid
     } else {
-        if (roundNum > START_HEAT_SEEKING) {
+        if (this->roundNum > this->params.startHeatSeeking) {
             centroids = getCentroids(coords, this->lights.size());
             deltas = getDistVecs(centroids, this->lights,
-                                            false, // one light per centroid
-                                            this->walls);
+                                            false); // one light per centroid
         } else {
-            vector<vec> destinations = POSITIONS;
-            rotate(destinations.begin(), destinations.begin() + 1, destinations.end());
-            deltas = vector<vec>();
+            vector<vec> destinations;
             for (int i = 0; i < int(this->lights.size()); i++) {
-                deltas.push_back(getDelta(this->lights[i], destinations[i], walls));
+                destinations.push_back(glmToArma(this->params.positions.at(i % this->params.positions.size())));
             }
+            rotate(destinations.begin(), destinations.begin() + 1, destinations.end());
+            deltas = getDeltas(this->lights, destinations);
         }
     }
+    QList<glm::vec2> proposed;
     for (int i = 0; i < this->lights.length(); i++) {
         // this gets the current position of the light
         glm::vec2 currPos = this->lights.at(i)->getPosition();
@@ -323,10 +346,18 @@ void MyPlayer::updateLights(QVector<QVector<int> >* board) {
                 velocity = velocity * -2;
             }
         }
+        proposed.append(armaToGlm(velocity));
+    }
 
-        velocities[i] = velocity;
-        this->lights.at(i)->moveTo(currPos.x+velocity[0],
-                                   currPos.y+velocity[1]);
+    // let the rollouts pick between the hand-coded velocities and sampled alternatives
+    if (this->usePlanner) {
+        proposed = this->planner.plan(board, this->lights, this->params.frogPosition, this->boardWalls, this->scene, proposed);
+    }
+
+    QVector<glm::vec2> moves;
+    for (int i = 0; i < this->lights.length(); i++) {
+        velocities[i] = glmToArma(proposed.at(i));
+        moves.append(proposed.at(i));
 
 
         /*
@@ -336,5 +367,6 @@ void MyPlayer::updateLights(QVector<QVector<int> >* board) {
          */
 
     }
+    return moves;
 }
 
@@ -2,6 +2,10 @@
 #define EXAMPLEPLAYER_H
 
 #include "player.h"
+#include "planner.h"
+#include "strategyparams.h"
+#include <armadillo>
+#include <vector>
 
 class MyPlayer : public Player
 {
@@ -10,13 +14,38 @@ public:
 
     // This method will be called before every step (i.e. before mosquitoes are moved).
     // board[x][y] tells you the number of mosquitoes at coordinate (x, y)
-    void updateLights(QVector<QVector<int> >* board);
+    QVector<glm::vec2> updateLights(QVector<QVector<int> >* board);
 
     // This method will only be called once, for the initial placement of the lights
     void initializeLights(QVector<QVector<int> >* board);
 
     // This method will only be called once per game, for the initial placement of the frog
     glm::vec2 initializeFrog(QVector<QVector<int> >* board);
+
+    StrategyParams params; // the constants of the strategy; the Scene has to be loaded with the same geometry
+    RolloutPlanner planner; // refines the hand-coded light velocities with parallel look-ahead rollouts
+    bool usePlanner; // off by default: the rollouts copy the observed mosquitoes every step, so their cost grows with the swarm
+
+private:
+    // everything the strategy remembers between steps lives here, so several games can run at once
+    int roundNum;
+    arma::mat centroids;
+    std::vector<arma::vec> velocities;
+    std::vector<Wall> derivedWalls; // T-walls and extended walls when there is no compiled scene
+    QList<Wall*> boardWalls; // the walls of the Board (this->walls holds the derived ones)
+
+    // the last path getDelta planned for a light; it is followed until the target moves or a wall gets in the way
+    struct PathCache {
+        bool valid;
+        glm::vec2 target;
+        std::vector<glm::vec2> waypoints; // the path after the light's position at planning time, ending at the target
+        int next; // the waypoint the light is heading for
+    };
+    std::vector<PathCache> paths;
+
+    arma::vec getDelta(Light* light, arma::vec destination);
+    std::vector<arma::vec> getDeltas(QList<Light*> lights, std::vector<arma::vec> destinations); // getDelta for every light, in parallel
+    std::vector<arma::vec> getDistVecs(arma::mat centroids, QList<Light*> lights, bool replace_centroids);
 };
 
 #endif // EXAMPLEPLAYER_H
@@ -0,0 +1,144 @@
+#include "planner.h"
+#include "board.h"
+#include "allocprofile.h"
+#include "taskpool.h"
+#include <QElapsedTimer>
+#include <math.h>
+#include <float.h>
+
+// Simulates a single candidate plan on its own copy of the starting board
+class Rollout
+{
+public:
+    Rollout(Board* start, Board* board, QList<glm::vec2> plan, RolloutPlanner* planner, QElapsedTimer* timer, float* score)
+    {
+        this->start = start;
+        this->board = board;
+        this->plan = plan;
+        this->planner = planner;
+        this->timer = timer;
+        this->score = score;
+    }
+
+    void run() {
+        ALLOC_SCOPE("rollouts");
+        if (this->timer->elapsed() > this->planner->timeBudget) {
+            // no time left to even copy the board
+            return;
+        }
+        Board* board = this->board;
+        board->copyFrom(this->start);
+        QVector<glm::vec2> moves = this->plan.toVector();
+
+        for (int s = 0; s < this->planner->horizon; s++) {
+            if (this->timer->elapsed() > this->planner->timeBudget) {
+                // out of time: leave the score at -FLT_MAX so this plan is never picked
+                return;
+            }
+            board->moveLights(moves);
+            board->moveMosquitoes();
+        }
+
+        board->updateMosquitoesEaten();
+        int caught = 0;
+        for (int i = 0; i < board->mosquitoes.length(); i++) {
+            if (board->mosquitoes.at(i)->isCaught && !board->mosquitoes.at(i)->isEaten) {
+                caught++;
+            }
+        }
+        float frogDistance = 0.0f;
+        for (int l = 0; l < board->lights.length(); l++) {
+            frogDistance += glm::length(board->lights.at(l)->getPosition() - board->frog->position);
+        }
+
+        *this->score = this->planner->eatenWeight * board->mosquitoesEaten
+                     + this->planner->caughtWeight * caught
+                     - this->planner->frogWeight * frogDistance;
+    }
+
+private:
+    Board* start;
+    Board* board;
+    QList<glm::vec2> plan;
+    RolloutPlanner* planner;
+    QElapsedTimer* timer;
+    float* score;
+};
+
+RolloutPlanner::RolloutPlanner()
+{
+    this->numCandidates = 32;
+    this->horizon = 30;
+    this->timeBudget = 40;
+    this->speed = 0.5f;
+    this->eatenWeight = 10.0f;
+    this->caughtWeight = 1.0f;
+    this->frogWeight = 0.05f;
+    this->random.seed(std::random_device()());
+    this->start = 0;
+}
+
+RolloutPlanner::~RolloutPlanner() {
+    delete this->start;
+    qDeleteAll(this->boards);
+}
+
+QList<glm::vec2> RolloutPlanner::samplePlan(QList<glm::vec2> heuristic) {
+    std::uniform_real_distribution<float> randomAngle(0.0f, 2*M_PI);
+    std::uniform_real_distribution<float> randomJitter(-M_PI / 4, M_PI / 4);
+    QList<glm::vec2> result;
+    for (int l = 0; l < heuristic.length(); l++) {
+        if (this->random() % 2 == 0 && glm::length(heuristic.at(l)) > 0.0f) {
+            // perturb the heuristic direction by up to 45 degrees either way
+            float jitter = randomJitter(this->random);
+            float angle = atan2(heuristic.at(l).y, heuristic.at(l).x) + jitter;
+            result.append(glm::vec2(cos(angle), sin(angle)) * this->speed);
+        } else {
+            float angle = randomAngle(this->random);
+            result.append(glm::vec2(cos(angle), sin(angle)) * this->speed);
+        }
+    }
+    return result;
+}
+
+QList<glm::vec2> RolloutPlanner::plan(QVector<QVector<int> >* board,
+                                      QList<Light*> lights,
+                                      glm::vec2 frogPosition,
+                                      QList<Wall*> walls,
+                                      Scene* scene,
+                                      QList<glm::vec2> heuristic) {
+    ALLOC_SCOPE("rollouts");
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QList<glm::vec2> > candidates;
+    candidates.append(heuristic);
+    for (int c = 1; c < this->numCandidates; c++) {
+        candidates.append(samplePlan(heuristic));
+    }
+
+    // every rollout forks the same start, so all plans are scored against the same mosquito moves
+    if (!this->start) {
+        this->start = new Board(0);
+    }
+    this->start->loadObservation(board, lights, frogPosition, walls, scene, this->random());
+    if (timer.elapsed() > this->timeBudget) {
+        return heuristic;
+    }
+    while (this->boards.size() < candidates.length()) {
+        this->boards.append(new Board(0));
+    }
+    QVector<float> scores(candidates.length(), -FLT_MAX);
+    // on the shared pool, so a plan made inside a pipelined decision or a VecEnv step doesn't add threads
+    TaskPool::shared()->parallelFor(candidates.length(), [&](int c) {
+        Rollout(this->start, this->boards.at(c), candidates.at(c), this, &timer, &scores[c]).run();
+    });
+
+    int best = 0;
+    for (int c = 1; c < candidates.length(); c++) {
+        if (scores.at(c) > scores.at(best)) {
+            best = c;
+        }
+    }
+    return candidates.at(best);
+}
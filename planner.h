@@ -0,0 +1,45 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <QList>
+#include <QVector>
+#include <random>
+#include <include/glm/glm.hpp>
+#include "light.h"
+#include "wall.h"
+
+class Board;
+class Scene;
+
+class RolloutPlanner
+{
+public:
+    RolloutPlanner();
+    ~RolloutPlanner();
+
+    int numCandidates; // number of light-velocity plans sampled per step (the first one is always the heuristic plan)
+    int horizon; // number of steps each plan is simulated ahead
+    int timeBudget; // milliseconds allowed per call to plan(); plans that don't finish in time are discarded
+    float speed; // length of the sampled light velocities
+    float eatenWeight; // score per mosquito eaten during a rollout
+    float caughtWeight; // score per mosquito caught at the end of a rollout
+    float frogWeight; // score penalty per unit of distance between the lights and the frog at the end of a rollout
+
+    // Samples candidate plans around the heuristic velocities, simulates each of them on a copy of the board
+    // built from the player's observation, and returns the per-light velocity of the best scoring plan.
+    // If building the copy already uses up the time budget, the heuristic is returned as it is.
+    QList<glm::vec2> plan(QVector<QVector<int> >* board, QList<Light*> lights, glm::vec2 frogPosition,
+                          QList<Wall*> walls, Scene* scene, QList<glm::vec2> heuristic);
+
+private:
+    RolloutPlanner(const RolloutPlanner&) = delete;
+    RolloutPlanner& operator=(const RolloutPlanner&) = delete;
+
+    Board* start; // the observation the rollouts copy, reloaded every call so its arena is reused
+    QVector<Board*> boards; // one per candidate, copied from start for every rollout (also reusing their arenas)
+    std::mt19937 random;
+
+    QList<glm::vec2> samplePlan(QList<glm::vec2> heuristic);
+};
+
+#endif // PLANNER_H
@@ -2,6 +2,9 @@
 
 Player::Player()
 {
-
+    this->scene = 0;
+    this->density = 0;
+    this->delta = 0;
+    this->observationLag = 0;
 }
 
@@ -3,9 +3,14 @@
 
 #include <include/glm/glm.hpp>
 #include <QList>
+#include <QVector>
 #include "wall.h"
 #include "light.h"
 
+class Scene;
+class DensityMap;
+struct StepDelta;
+
 class Player
 {
 
@@ -13,13 +18,24 @@ public:
     // Player is an abstract base class that your class MUST inherit from.
     Player();
 
-    QList<Light*> lights; // These are the actual lights in Board (i.e. you can and should move them)
+    QList<Light*> lights; // These are the actual lights in Board. Don't move them yourself; return the moves from updateLights
     QList<Wall*> walls; // This is just a copy of the walls in Board (i.e. you cannot move the walls from Player)
     QString playerName;
+    Scene* scene; // The compiled wall layout (may be null). It also holds derived walls and the static path graph for MyPlayer
+    DensityMap* density; // Region counts and coarse density grids of the board passed to updateLights (may be null)
+    const StepDelta* delta; // What changed since the board passed to the previous updateLights (may be null)
+
+    // How many rounds old the board passed to updateLights is. This is 0 unless the Board runs in pipelined mode,
+    // where it is 1: updateLights runs on another thread while the mosquitoes move, it gets the board from before
+    // they moved, and the moves it returns are applied in the next step.
+    int observationLag;
 
     // This method will be called before every step (i.e. before mosquitoes are moved).
     // board[x][y] tells you the number of mosquitoes at coordinate (x, y)
-    virtual void updateLights(QVector<QVector<int> >* board) = 0;
+    // Return how far each light should move this step (one entry per light, in the order of lights).
+    // The Board checks all the moves at once and makes the valid ones; a light whose move is longer
+    // than 3 units, leaves the board or crosses a wall stays where it is.
+    virtual QVector<glm::vec2> updateLights(QVector<QVector<int> >* board) = 0;
 
     // This method will only be called once, for the initial placement of the lights
     virtual void initializeLights(QVector<QVector<int> >* board) = 0;
@@ -0,0 +1,277 @@
+// Python bindings for the simulator. The arrays the Board hands out (mosquito_positions, occupancy, ...)
+// are NumPy views of the Board's own memory: they cost nothing to get, always show the current state,
+// and stay valid until the next initialize(). They are read-only.
+//
+//     import buzzbuzz, numpy as np
+//
+//     class Chaser(buzzbuzz.Player):
+//         def update_lights(self, board):
+//             target = board.mosquito_positions[~board.mosquito_eaten].mean(axis=0)
+//             delta = target - board.light_positions
+//             return delta / np.maximum(np.linalg.norm(delta, axis=1, keepdims=True), 1) * 0.5
+//
+//     board = buzzbuzz.Board(Chaser())
+//     board.load_walls("wall_setup.txt")
+//     board.initialize()
+//     while not board.finished():
+//         board.step()
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <stdexcept>
+#include "board.h"
+#include "scene.h"
+#include "player.h"
+#include "vecenv.h"
+
+namespace py = pybind11;
+
+// A Player whose decisions are made by the methods of a Python subclass
+class PythonPlayer : public Player
+{
+public:
+    Board* board; // the Board this player plays on; update_lights gets it to look at
+
+    PythonPlayer() {
+        this->board = 0;
+        this->playerName = "Python Player";
+    }
+
+    QVector<glm::vec2> updateLights(QVector<QVector<int> >* board) override {
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(static_cast<const Player*>(this), "update_lights");
+        if (!override) {
+            throw std::runtime_error("buzzbuzz.Player subclasses must implement update_lights(board)");
+        }
+        auto moves = override(py::cast(this->board)).cast<py::array_t<float, py::array::c_style | py::array::forcecast> >();
+        if (moves.ndim() != 2 || moves.shape(0) != this->lights.size() || moves.shape(1) != 2) {
+            throw std::runtime_error("update_lights must return one (dx, dy) row per light");
+        }
+        QVector<glm::vec2> result(this->lights.size());
+        auto m = moves.unchecked<2>();
+        for (int l = 0; l < result.size(); l++) {
+            result[l] = glm::vec2(m(l, 0), m(l, 1));
+        }
+        return result;
+    }
+
+    // initialize_lights(board) may return one (x, y) row per light; otherwise the lights start at (0, 0)
+    void initializeLights(QVector<QVector<int> >* board) override {
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(static_cast<const Player*>(this), "initialize_lights");
+        py::object positions = override ? override(py::cast(this->board)) : py::object(py::none());
+        if (positions.is_none()) {
+            for (int l = 0; l < this->lights.size(); l++) {
+                glm::vec2 position = this->lights.at(l)->getPosition();
+                this->lights.at(l)->setInitialPosition(position.x, position.y);
+            }
+            return;
+        }
+        auto p = positions.cast<py::array_t<float, py::array::c_style | py::array::forcecast> >();
+        if (p.ndim() != 2 || p.shape(0) != this->lights.size() || p.shape(1) != 2) {
+            throw std::runtime_error("initialize_lights must return one (x, y) row per light");
+        }
+        auto rows = p.unchecked<2>();
+        for (int l = 0; l < this->lights.size(); l++) {
+            this->lights.at(l)->setInitialPosition(rows(l, 0), rows(l, 1));
+        }
+    }
+
+    // initialize_frog(board) may return (x, y); the frog sits in the middle otherwise
+    glm::vec2 initializeFrog(QVector<QVector<int> >* board) override {
+        py::gil_scoped_acquire gil;
+        py::function override = py::get_override(static_cast<const Player*>(this), "initialize_frog");
+        if (!override) {
+            return glm::vec2(this->board->boardSize / 2.0f, this->board->boardSize / 2.0f);
+        }
+        auto p = override(py::cast(this->board)).cast<py::array_t<float, py::array::c_style | py::array::forcecast> >();
+        if (p.size() != 2) {
+            throw std::runtime_error("initialize_frog must return (x, y)");
+        }
+        return glm::vec2(p.data()[0], p.data()[1]);
+    }
+};
+
+// The Python object owns the player, so the Board must not delete it
+struct BoardDeleter {
+    void operator()(Board* board) {
+        py::gil_scoped_release release; // a pending decision may need the GIL to finish
+        try {
+            board->setPipelined(false);
+        } catch (...) {
+            // the decision has finished; nobody is left to hear about its error
+        }
+        board->player = 0;
+        delete board;
+    }
+};
+
+// a read-only view of count rows of columns values of type T, rowStride bytes apart, kept alive by owner
+template <typename T>
+static py::array view(const void* data, ssize_t count, ssize_t columns, ssize_t rowStride, py::handle owner) {
+    std::vector<ssize_t> shape;
+    std::vector<ssize_t> strides;
+    shape.push_back(count);
+    strides.push_back(rowStride);
+    if (columns > 0) {
+        shape.push_back(columns);
+        strides.push_back(sizeof(T));
+    }
+    py::array result(py::dtype::of<T>(), shape, strides, const_cast<void*>(data), owner);
+    result.attr("setflags")(py::arg("write") = false);
+    return result;
+}
+
+static Mosquito* mosquitoArray(Board& board) {
+    Mosquito* first = board.mosquitoArray();
+    if (!first && !board.mosquitoes.isEmpty()) {
+        throw std::runtime_error("the mosquitoes are not stored as one array");
+    }
+    return first;
+}
+
+static py::tuple observation(VecEnv& env, py::handle owner) {
+    int n = env.numEnvs;
+    int g = env.gridSize;
+    std::vector<ssize_t> gridShape = {n, g, g};
+    std::vector<ssize_t> gridStrides = {(ssize_t) (g * g * sizeof(float)), (ssize_t) (g * sizeof(float)), (ssize_t) sizeof(float)};
+    py::array occupancy(py::dtype::of<float>(), gridShape, gridStrides, env.occupancy.data(), owner);
+    std::vector<ssize_t> lightShape = {n, env.numLights, 2};
+    std::vector<ssize_t> lightStrides = {(ssize_t) (env.numLights * 2 * sizeof(float)), (ssize_t) (2 * sizeof(float)), (ssize_t) sizeof(float)};
+    py::array lights(py::dtype::of<float>(), lightShape, lightStrides, env.lights.data(), owner);
+    py::array rewards = view<float>(env.rewards.data(), n, 0, sizeof(float), owner);
+    py::array dones = view<bool>(env.dones.data(), n, 0, sizeof(unsigned char), owner);
+    occupancy.attr("setflags")(py::arg("write") = false);
+    lights.attr("setflags")(py::arg("write") = false);
+    return py::make_tuple(occupancy, lights, rewards, dones);
+}
+
+PYBIND11_MODULE(buzzbuzz, m) {
+    m.doc() = "Mosquito Buzz Buzz simulator";
+
+    py::class_<Scene>(m, "Scene")
+        .def(py::init<>())
+        .def("load", [](Scene& scene, const std::string& path, int boardSize) {
+            return scene.load(QString::fromStdString(path), boardSize);
+        }, py::arg("layout_path"), py::arg("board_size") = 500)
+        .def_property_readonly("num_walls", [](Scene& scene) { return scene.numWalls; });
+
+    py::class_<Player, PythonPlayer>(m, "Player")
+        .def(py::init<>())
+        .def_property("name", [](Player& player) { return player.playerName.toStdString(); },
+                      [](Player& player, const std::string& name) { player.playerName = QString::fromStdString(name); })
+        .def_readonly("observation_lag", &Player::observationLag);
+
+    py::class_<Board, std::unique_ptr<Board, BoardDeleter> >(m, "Board", py::dynamic_attr())
+        .def(py::init([](Player* player) {
+            Board* board = new Board(player);
+            PythonPlayer* pythonPlayer = dynamic_cast<PythonPlayer*>(player);
+            if (pythonPlayer) {
+                pythonPlayer->board = board;
+            }
+            return std::unique_ptr<Board, BoardDeleter>(board);
+        }), py::arg("player").none(false), py::keep_alive<1, 2>())
+        .def_readwrite("num_mosquitoes", &Board::numMosquitoes)
+        .def_readwrite("num_lights", &Board::numLights)
+        .def_readwrite("board_size", &Board::boardSize)
+        .def_readwrite("capture_target", &Board::captureTarget)
+        .def_readwrite("max_rounds", &Board::maxRounds)
+        .def_readonly("curr_round", &Board::currRound)
+        .def_readonly("mosquitoes_eaten", &Board::mosquitoesEaten)
+        .def_readonly("mosquitoes_caught", &Board::mosquitoesCaught)
+        .def("seed", &Board::seed)
+        .def("set_pipelined", [](Board& board, bool pipelined) {
+            // update_lights gets the live Board, whose mosquitoes move on the calling thread while a pipelined
+            // decision runs; only players that read nothing but the observation can run alongside
+            if (pipelined && dynamic_cast<PythonPlayer*>(board.player)) {
+                throw std::runtime_error("Python players can't run pipelined: update_lights reads the live board");
+            }
+            py::gil_scoped_release release;
+            board.setPipelined(pipelined);
+        })
+        .def("set_scene", &Board::setScene, py::keep_alive<1, 2>())
+        .def("load_walls", [](py::object self, const std::string& path) {
+            // the scene is kept on the Python object, so it lives as long as the Board
+            py::object scene = py::cast(new Scene(), py::return_value_policy::take_ownership);
+            if (!scene.cast<Scene*>()->load(QString::fromStdString(path), self.cast<Board&>().boardSize)) {
+                throw std::runtime_error("could not read " + path);
+            }
+            self.cast<Board&>().setScene(scene.cast<Scene*>());
+            self.attr("scene") = scene;
+        }, py::arg("layout_path"))
+        // the Player's methods are called with the GIL taken back
+        .def("initialize", &Board::initialize, py::call_guard<py::gil_scoped_release>())
+        .def("step", &Board::step, py::call_guard<py::gil_scoped_release>())
+        .def("finished", &Board::finished)
+        .def_property_readonly("mosquito_positions", [](py::object self) {
+            Board& board = self.cast<Board&>();
+            Mosquito* first = mosquitoArray(board);
+            return view<float>(first ? &first->position : 0, board.mosquitoes.length(), 2, sizeof(Mosquito), self);
+        })
+        .def_property_readonly("mosquito_caught", [](py::object self) {
+            Board& board = self.cast<Board&>();
+            Mosquito* first = mosquitoArray(board);
+            return view<bool>(first ? &first->isCaught : 0, board.mosquitoes.length(), 0, sizeof(Mosquito), self);
+        })
+        .def_property_readonly("mosquito_eaten", [](py::object self) {
+            Board& board = self.cast<Board&>();
+            Mosquito* first = mosquitoArray(board);
+            return view<bool>(first ? &first->isEaten : 0, board.mosquitoes.length(), 0, sizeof(Mosquito), self);
+        })
+        .def_property_readonly("light_positions", [](py::object self) {
+            Board& board = self.cast<Board&>();
+            Light* first = board.lightArray();
+            if (!first && !board.lights.isEmpty()) {
+                throw std::runtime_error("the lights are not stored as one array");
+            }
+            return view<float>(first ? first->positionData() : 0, board.lights.length(), 2, sizeof(Light), self);
+        })
+        .def_property_readonly("frog_position", [](Board& board) {
+            return py::make_tuple(board.frog->position.x, board.frog->position.y);
+        })
+        .def_property_readonly("occupancy", [](py::object self) {
+            // occupancy[x, y] is the number of mosquitoes in cell (x, y), as of the last step
+            Board& board = self.cast<Board&>();
+            int size = board.boardSize + 1;
+            if (board.occupancy.size() != size * size) {
+                board.generateBoardForPlayer();
+            }
+            std::vector<ssize_t> shape = {size, size};
+            std::vector<ssize_t> strides = {(ssize_t) (size * sizeof(int)), (ssize_t) sizeof(int)};
+            py::array result(py::dtype::of<int>(), shape, strides, board.occupancy.data(), self);
+            result.attr("setflags")(py::arg("write") = false);
+            return result;
+        });
+
+    // reset() and step(actions) return (occupancy, lights, rewards, dones) as views of the VecEnv's buffers,
+    // which the next step overwrites: copy them to keep them
+    py::class_<VecEnv>(m, "VecEnv")
+        .def(py::init<int, int, int, Scene*, int>(), py::arg("num_envs"), py::arg("num_lights") = 4,
+             py::arg("num_mosquitoes") = 500, py::arg("scene") = (Scene*) 0, py::arg("grid_size") = 64,
+             py::keep_alive<1, 5>())
+        .def_readonly("num_envs", &VecEnv::numEnvs)
+        .def_readonly("num_lights", &VecEnv::numLights)
+        .def_readonly("grid_size", &VecEnv::gridSize)
+        .def_readwrite("max_rounds", &VecEnv::maxRounds)
+        .def("seed", &VecEnv::seed)
+        .def("reset", [](py::object self) {
+            VecEnv& env = self.cast<VecEnv&>();
+            {
+                py::gil_scoped_release release;
+                env.reset();
+            }
+            return observation(env, self);
+        })
+        .def("step", [](py::object self, py::array_t<float, py::array::c_style | py::array::forcecast> actions) {
+            VecEnv& env = self.cast<VecEnv&>();
+            if (actions.ndim() != 3 || actions.shape(0) != env.numEnvs || actions.shape(1) != env.numLights ||
+                    actions.shape(2) != 2) {
+                throw std::runtime_error("actions must have the shape (num_envs, num_lights, 2)");
+            }
+            {
+                py::gil_scoped_release release;
+                env.step(actions.data());
+            }
+            return observation(env, self);
+        }, py::arg("actions"));
+}
@@ -0,0 +1,31 @@
+# Builds the buzzbuzz module from the simulator sources: pip install ./python
+# Needs pybind11, Qt 5 (found through pkg-config) and Armadillo.
+import os
+import subprocess
+from setuptools import setup
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+SOURCES = ["board.cpp", "mosquito.cpp", "light.cpp", "wall.cpp", "frog.cpp", "player.cpp", "myplayer.cpp",
+           "matrix.cpp", "planner.cpp", "scene.cpp", "lightindex.cpp", "arena.cpp", "log.cpp", "metrics.cpp",
+           "strategyparams.cpp", "boardkernel.cpp", "densitymap.cpp", "taskpool.cpp", "allocprofile.cpp", "vecenv.cpp",
+           "densityfield.cpp", "stepdelta.cpp"]
+
+
+def pkg_config(*args):
+    return subprocess.check_output(["pkg-config"] + list(args) + ["Qt5Core", "Qt5Gui"]).decode().split()
+
+
+setup(
+    name="buzzbuzz",
+    version="0.1",
+    ext_modules=[Pybind11Extension(
+        "buzzbuzz",
+        ["buzzbuzz.cpp"] + [os.path.join(ROOT, source) for source in SOURCES],
+        include_dirs=[ROOT, os.path.join(ROOT, "include")] + [flag[2:] for flag in pkg_config("--cflags-only-I")],
+        extra_compile_args=["-fPIC"],
+        extra_link_args=pkg_config("--libs") + ["-larmadillo"],
+        cxx_std=11,
+    )],
+    cmdclass={"build_ext": build_ext},
+)
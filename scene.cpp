@@ -0,0 +1,393 @@
+#include "scene.h"
+#include "matrix.h"
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QTextStream>
+#include <QStringList>
+#include <vector>
+#include <math.h>
+
+using namespace std;
+
+// Layout of a compiled scene file. Every section starts at an 8-byte aligned offset
+// from the beginning of the file so that it can be used in place once mapped.
+struct SceneHeader {
+    char magic[4];
+    quint32 version;
+    quint32 fileSize;
+    quint32 numWalls;
+    quint32 numPlayerWalls;
+    quint32 gridSize;
+    float cellSize;
+    quint32 numCellWalls;
+    quint32 numNodes;
+    quint32 numEdges;
+    quint32 clearanceSize;
+    float clearanceCellSize;
+    quint32 wallsOffset;
+    quint32 playerWallsOffset;
+    quint32 cellStartOffset;
+    quint32 cellWallsOffset;
+    quint32 nodesOffset;
+    quint32 edgeStartOffset;
+    quint32 edgesOffset;
+    quint32 clearanceOffset;
+};
+
+static const char SCENE_MAGIC[4] = {'B', 'Z', 'S', 'C'};
+static const quint32 SCENE_VERSION = 2;
+static const int SCENE_GRID_SIZE = 32;
+static const float CLEARANCE_CELL_SIZE = 4.0f;
+
+static_assert(sizeof(Wall) == 4 * sizeof(float), "Walls are stored in scene files as 4 floats");
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "Nodes are stored in scene files as 2 floats");
+
+Scene::Scene()
+{
+    this->data = 0;
+    unload();
+}
+
+Scene::~Scene()
+{
+    unload();
+}
+
+QString Scene::cacheDirectory() {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    dir = dir + "/scenes";
+    QDir().mkpath(dir);
+    return dir;
+}
+
+bool Scene::load(const QString& layoutPath, int boardSize, const StrategyParams& params) {
+    unload();
+
+    QFile layoutFile(layoutPath);
+    layoutFile.open(QIODevice::ReadOnly);
+    if (!layoutFile.isOpen()) {
+        return false;
+    }
+    QByteArray layout = layoutFile.readAll();
+
+    // the cache key covers the layout and everything the derived data depends on
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(layout);
+    hash.addData(reinterpret_cast<const char*>(&SCENE_VERSION), sizeof(SCENE_VERSION));
+    hash.addData(reinterpret_cast<const char*>(&boardSize), sizeof(boardSize));
+    for (float param : params.geometry()) {
+        hash.addData(reinterpret_cast<const char*>(&param), sizeof(param));
+    }
+    QString scenePath = cacheDirectory() + "/" + QString(hash.result().toHex()) + ".scene";
+
+    if (map(scenePath)) {
+        return true;
+    }
+    if (!compile(layout, scenePath, boardSize, params)) {
+        return false;
+    }
+    return map(scenePath);
+}
+
+void Scene::unload() {
+    if (this->data) {
+        this->file.unmap(this->data);
+        this->file.close();
+    }
+    this->data = 0;
+    this->wallData = 0;
+    this->playerWallData = 0;
+    this->numWalls = 0;
+    this->numPlayerWalls = 0;
+    this->gridSize = 0;
+    this->cellSize = 0.0f;
+    this->cellStart = 0;
+    this->cellWalls = 0;
+    this->clearanceSize = 0;
+    this->clearanceCellSize = 0.0f;
+    this->clearanceField = 0;
+    this->numNodes = 0;
+    this->nodes = 0;
+    this->edgeStart = 0;
+    this->edges = 0;
+}
+
+bool Scene::isLoaded() {
+    return this->data != 0;
+}
+
+QList<Wall*> Scene::walls() {
+    QList<Wall*> result;
+    for (int w = 0; w < this->numWalls; w++) {
+        result.append(&this->wallData[w]);
+    }
+    return result;
+}
+
+QList<Wall*> Scene::playerWalls() {
+    QList<Wall*> result;
+    for (int w = 0; w < this->numPlayerWalls; w++) {
+        result.append(&this->playerWallData[w]);
+    }
+    return result;
+}
+
+static int gridCell(float coord, float cellSize, int gridSize) {
+    int cell = (int) glm::floor(coord / cellSize);
+    if (cell < 0) return 0;
+    if (cell >= gridSize) return gridSize - 1;
+    return cell;
+}
+
+int Scene::cellIndex(float coord) {
+    return gridCell(coord, this->cellSize, this->gridSize);
+}
+
+float Scene::clearance(glm::vec2 pos) {
+    if (pos.x < 0.0f || pos.y < 0.0f) {
+        return 0.0f;
+    }
+    int x = (int) (pos.x / this->clearanceCellSize);
+    int y = (int) (pos.y / this->clearanceCellSize);
+    if (x >= this->clearanceSize || y >= this->clearanceSize) {
+        return 0.0f;
+    }
+    return this->clearanceField[x * this->clearanceSize + y];
+}
+
+bool Scene::segmentHitsWall(glm::vec2 start, glm::vec2 end) {
+    // short moves in open space can't reach any wall (most mosquito and light moves)
+    float c = clearance(start);
+    glm::vec2 move = end - start;
+    if (glm::dot(move, move) < c * c) {
+        return false;
+    }
+
+    int x0 = cellIndex(glm::min(start.x, end.x));
+    int x1 = cellIndex(glm::max(start.x, end.x));
+    int y0 = cellIndex(glm::min(start.y, end.y));
+    int y1 = cellIndex(glm::max(start.y, end.y));
+
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) > this->numWalls) {
+        // the segment spans more cells than there are walls, so the index doesn't help
+        for (int w = 0; w < this->numWalls; w++) {
+            if (this->wallData[w].isInvalidMove(start, end)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (int x = x0; x <= x1; x++) {
+        for (int y = y0; y <= y1; y++) {
+            int cell = x * this->gridSize + y;
+            for (quint32 i = this->cellStart[cell]; i < this->cellStart[cell+1]; i++) {
+                if (this->wallData[this->cellWalls[i]].isInvalidMove(start, end)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool Scene::map(QString scenePath) {
+    this->file.setFileName(scenePath);
+    if (!this->file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 size = this->file.size();
+    if (size < (qint64) sizeof(SceneHeader)) {
+        this->file.close();
+        return false;
+    }
+    // private mapping: pages are shared with the cache file until something writes to them
+    uchar* mapped = this->file.map(0, size, QFileDevice::MapPrivateOption);
+    if (!mapped) {
+        this->file.close();
+        return false;
+    }
+    SceneHeader* header = reinterpret_cast<SceneHeader*>(mapped);
+    if (memcmp(header->magic, SCENE_MAGIC, 4) != 0 || header->version != SCENE_VERSION || header->fileSize != size) {
+        this->file.unmap(mapped);
+        this->file.close();
+        return false;
+    }
+
+    this->data = mapped;
+    this->numWalls = header->numWalls;
+    this->numPlayerWalls = header->numPlayerWalls;
+    this->gridSize = header->gridSize;
+    this->cellSize = header->cellSize;
+    this->numNodes = header->numNodes;
+    this->wallData = reinterpret_cast<Wall*>(mapped + header->wallsOffset);
+    this->playerWallData = reinterpret_cast<Wall*>(mapped + header->playerWallsOffset);
+    this->cellStart = reinterpret_cast<quint32*>(mapped + header->cellStartOffset);
+    this->cellWalls = reinterpret_cast<quint32*>(mapped + header->cellWallsOffset);
+    this->nodes = reinterpret_cast<glm::vec2*>(mapped + header->nodesOffset);
+    this->edgeStart = reinterpret_cast<quint32*>(mapped + header->edgeStartOffset);
+    this->edges = reinterpret_cast<quint32*>(mapped + header->edgesOffset);
+    this->clearanceSize = header->clearanceSize;
+    this->clearanceCellSize = header->clearanceCellSize;
+    this->clearanceField = reinterpret_cast<float*>(mapped + header->clearanceOffset);
+    return true;
+}
+
+// appends a section to the file contents and returns its offset
+template <typename T>
+quint32 appendSection(QByteArray& contents, const T* items, int count) {
+    while (contents.size() % 8 != 0) {
+        contents.append('\0');
+    }
+    quint32 offset = contents.size();
+    contents.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+    return offset;
+}
+
+static float distanceToWall(glm::vec2 pos, const Wall& wall) {
+    glm::vec2 along = wall.point2 - wall.point1;
+    float length2 = glm::dot(along, along);
+    float t = length2 > 0.0f ? glm::clamp(glm::dot(pos - wall.point1, along) / length2, 0.0f, 1.0f) : 0.0f;
+    return glm::length(pos - (wall.point1 + t * along));
+}
+
+bool Scene::compile(QByteArray layout, QString scenePath, int boardSize, const StrategyParams& params) {
+    // parse the text layout (same format as wall_setup.txt)
+    vector<Wall> walls;
+    int numWalls = 0;
+    QTextStream in(&layout);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        QStringList bits = line.split(",");
+        if (bits.size() == 1) {
+            // get number of walls
+            numWalls = bits.at(0).trimmed().toInt();
+        } else {
+            // get wall endpoints (MUST HAVE 4 in each )
+            if (bits.size() != 4) {
+                qDebug() << "Wall endpoints incorrectly specified";
+                break;
+            } else if (int(walls.size()) < numWalls) {
+                walls.push_back(Wall(glm::vec2(bits.at(0).trimmed().toFloat(), bits.at(1).trimmed().toFloat()),
+                                     glm::vec2(bits.at(2).trimmed().toFloat(), bits.at(3).trimmed().toFloat())));
+            }
+        }
+    }
+    if (int(walls.size()) < numWalls) {
+        qDebug() << "You specified " << numWalls << " wall(s) but only provided endpoints for " << walls.size();
+        qDebug() << "Using " << walls.size() << " wall(s)";
+    }
+
+    QList<Wall*> wallPtrs;
+    for (Wall& wall : walls) {
+        wallPtrs.append(&wall);
+    }
+    vector<Wall> playerWalls = getPlayerWalls(wallPtrs, params);
+    QList<Wall*> playerWallPtrs;
+    for (Wall& wall : playerWalls) {
+        playerWallPtrs.append(&wall);
+    }
+
+    // grid index: every wall is listed in all the cells its bounding box overlaps
+    float cellSize = (float) boardSize / SCENE_GRID_SIZE;
+    int numCells = SCENE_GRID_SIZE * SCENE_GRID_SIZE;
+    vector<quint32> cellStart(numCells + 1, 0);
+    vector<quint32> cellWalls;
+    for (int pass = 0; pass < 2; pass++) {
+        vector<quint32> filled(cellStart);
+        for (int w = 0; w < int(walls.size()); w++) {
+            int x0 = gridCell(glm::min(walls[w].point1.x, walls[w].point2.x), cellSize, SCENE_GRID_SIZE);
+            int x1 = gridCell(glm::max(walls[w].point1.x, walls[w].point2.x), cellSize, SCENE_GRID_SIZE);
+            int y0 = gridCell(glm::min(walls[w].point1.y, walls[w].point2.y), cellSize, SCENE_GRID_SIZE);
+            int y1 = gridCell(glm::max(walls[w].point1.y, walls[w].point2.y), cellSize, SCENE_GRID_SIZE);
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    int cell = x * SCENE_GRID_SIZE + y;
+                    if (pass == 0) {
+                        cellStart[cell + 1]++;
+                    } else {
+                        cellWalls[filled[cell]++] = w;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int c = 0; c < numCells; c++) {
+                cellStart[c + 1] += cellStart[c];
+            }
+            cellWalls.resize(cellStart[numCells]);
+        }
+    }
+
+    // clearance field: distance from each cell's centre to the closest wall, less the distance from the
+    // centre to the cell's corners, so it holds for every point in the cell
+    int clearanceSize = (int) ceil(boardSize / CLEARANCE_CELL_SIZE);
+    float halfDiagonal = CLEARANCE_CELL_SIZE * 0.5f * sqrt(2.0f);
+    vector<float> clearance(clearanceSize * clearanceSize);
+    for (int x = 0; x < clearanceSize; x++) {
+        for (int y = 0; y < clearanceSize; y++) {
+            glm::vec2 centre = glm::vec2(x + 0.5f, y + 0.5f) * CLEARANCE_CELL_SIZE;
+            float closest = 2.0f * boardSize;
+            for (int w = 0; w < int(walls.size()); w++) {
+                closest = glm::min(closest, distanceToWall(centre, walls[w]));
+            }
+            clearance[x * clearanceSize + y] = glm::max(closest - halfDiagonal, 0.0f);
+        }
+    }
+
+    // static path graph between the corners of the player walls
+    vector<Node> corners = getWallNodes(playerWallPtrs, params);
+    vector<glm::vec2> nodes;
+    vector<quint32> edgeStart;
+    vector<quint32> edges;
+    for (int i = 0; i < int(corners.size()); i++) {
+        nodes.push_back(corners[i].glm());
+        edgeStart.push_back(edges.size());
+        for (int j = 0; j < int(corners.size()); j++) {
+            if (corners[i] != corners[j] && straightShot(corners[i], corners[j], playerWallPtrs)) {
+                edges.push_back(j);
+            }
+        }
+    }
+    edgeStart.push_back(edges.size());
+
+    SceneHeader header;
+    memset(&header, 0, sizeof(header));
+    QByteArray contents(sizeof(SceneHeader), '\0');
+    header.wallsOffset = appendSection(contents, walls.data(), walls.size());
+    header.playerWallsOffset = appendSection(contents, playerWalls.data(), playerWalls.size());
+    header.cellStartOffset = appendSection(contents, cellStart.data(), cellStart.size());
+    header.cellWallsOffset = appendSection(contents, cellWalls.data(), cellWalls.size());
+    header.nodesOffset = appendSection(contents, nodes.data(), nodes.size());
+    header.edgeStartOffset = appendSection(contents, edgeStart.data(), edgeStart.size());
+    header.edgesOffset = appendSection(contents, edges.data(), edges.size());
+    header.clearanceOffset = appendSection(contents, clearance.data(), clearance.size());
+    memcpy(header.magic, SCENE_MAGIC, 4);
+    header.version = SCENE_VERSION;
+    header.fileSize = contents.size();
+    header.numWalls = walls.size();
+    header.numPlayerWalls = playerWalls.size();
+    header.gridSize = SCENE_GRID_SIZE;
+    header.cellSize = cellSize;
+    header.numCellWalls = cellWalls.size();
+    header.numNodes = nodes.size();
+    header.numEdges = edges.size();
+    header.clearanceSize = clearanceSize;
+    header.clearanceCellSize = CLEARANCE_CELL_SIZE;
+    contents.replace(0, sizeof(SceneHeader), reinterpret_cast<const char*>(&header), sizeof(SceneHeader));
+
+    // write to a temporary file first so that other processes never map a half-written scene
+    QSaveFile out(scenePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qDebug() << "WARNING: Could not write scene cache" << scenePath;
+        return false;
+    }
+    out.write(contents);
+    return out.commit();
+}
@@ -0,0 +1,63 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <QList>
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <include/glm/glm.hpp>
+#include "wall.h"
+#include "strategyparams.h"
+
+// A wall layout compiled from a text file like wall_setup.txt into a binary file that
+// is cached on disk (keyed by a hash of the text) and memory-mapped when loaded.
+// Besides the walls themselves it stores everything that only depends on the layout:
+// the walls the Player plans around, a grid index over the walls, a distance field of
+// the clearance around the walls and the static part of the path graph between wall corners.
+class Scene
+{
+public:
+    Scene();
+    ~Scene();
+
+    // compiles the layout (if it isn't cached yet) and maps it; false if the layout can't be read.
+    // The derived walls and the path graph are built with the geometry in params.
+    bool load(const QString& layoutPath, int boardSize, const StrategyParams& params = StrategyParams());
+    void unload();
+    bool isLoaded();
+
+    int numWalls;
+    int numPlayerWalls;
+    QList<Wall*> walls(); // the walls from the layout, pointing into the mapped file
+    QList<Wall*> playerWalls(); // T-walls and extended walls derived from the layout for the Player
+
+    bool segmentHitsWall(glm::vec2 start, glm::vec2 end); // same as testing isInvalidMove against every wall, but only looks at nearby ones
+    float clearance(glm::vec2 pos); // a lower bound on the distance from pos to the closest wall (0 outside the board)
+
+    // static path graph between the wall corners (in adjacency list form)
+    int numNodes;
+    glm::vec2* nodes;
+    quint32* edgeStart; // the neighbours of node n are edges[edgeStart[n]] up to edges[edgeStart[n+1]]
+    quint32* edges;
+
+    static QString cacheDirectory();
+
+private:
+    QFile file;
+    uchar* data;
+    Wall* wallData;
+    Wall* playerWallData;
+    int gridSize; // the wall index is gridSize x gridSize cells covering the board
+    float cellSize;
+    quint32* cellStart; // the walls overlapping cell c are cellWalls[cellStart[c]] up to cellWalls[cellStart[c+1]]
+    quint32* cellWalls;
+    int clearanceSize; // the clearance field is clearanceSize x clearanceSize cells of clearanceCellSize
+    float clearanceCellSize;
+    float* clearanceField; // for every cell, the distance from the closest point in the cell to the closest wall
+
+    static bool compile(QByteArray layout, QString scenePath, int boardSize, const StrategyParams& params);
+    bool map(QString scenePath);
+    int cellIndex(float coord);
+};
+
+#endif // SCENE_H
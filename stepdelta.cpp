@@ -0,0 +1,29 @@
+#include "stepdelta.h"
+#include "mosquito.h"
+
+StepDelta::StepDelta()
+{
+    this->round = 0;
+}
+
+void StepDelta::clear() {
+    // resize() doesn't give up the capacity (clear() does on older Qt 5)
+    this->cells.resize(0);
+    this->caught.resize(0);
+    this->released.resize(0);
+    this->eaten.resize(0);
+    this->lightMoves.resize(0);
+    this->lightMoveAccepted.resize(0);
+}
+
+void StepDelta::recordMosquito(const Mosquito* m, bool wasCaught, bool wasEaten) {
+    if (m->isEaten) {
+        if (!wasEaten) {
+            this->eaten.append(m->position);
+        }
+    } else if (m->isCaught && !wasCaught) {
+        this->caught.append(m->position);
+    } else if (!m->isCaught && wasCaught) {
+        this->released.append(m->position);
+    }
+}
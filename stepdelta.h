@@ -0,0 +1,39 @@
+#ifndef STEPDELTA_H
+#define STEPDELTA_H
+
+#include <QVector>
+#include <include/glm/glm.hpp>
+
+class Mosquito;
+
+// What changed between two observations of a Board, so a Player can keep clusters, sums or target lists up
+// to date at a cost proportional to the change instead of rescanning the board. The Board fills one of these
+// while a step runs and publishes it with the next observation; clear() keeps the storage, so after the
+// first few rounds recording doesn't allocate.
+struct StepDelta
+{
+    StepDelta();
+
+    struct Cell {
+        int x;
+        int y;
+        int before; // count in the previous observation
+        int after; // count in this one
+    };
+
+    int round; // the Board's round when this was published
+    QVector<Cell> cells; // the cells whose count changed
+    // where the mosquitoes whose state changed were after their move (list indices change when the Board
+    // reorders its mosquitoes, positions don't)
+    QVector<glm::vec2> caught; // newly caught by a light
+    QVector<glm::vec2> released; // no longer caught (the light moved away or a wall got in between)
+    QVector<glm::vec2> eaten; // newly eaten by the frog
+    QVector<glm::vec2> lightMoves; // the move asked of every light, in the order of the Board's lights
+    QVector<bool> lightMoveAccepted; // ... and whether the Board made it
+
+    void clear();
+    // records a mosquito whose move has just been made, given its state before the move
+    void recordMosquito(const Mosquito* m, bool wasCaught, bool wasEaten);
+};
+
+#endif // STEPDELTA_H
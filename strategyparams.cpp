@@ -0,0 +1,87 @@
+#include "strategyparams.h"
+
+static const float PARAMS_BOARD_SIZE = 500;
+
+StrategyParams::StrategyParams()
+{
+    this->smoothing = 10;
+    this->startHeatSeeking = 300;
+    this->mosquitoesToLeave = 50;
+    this->frogPosition = glm::vec2(250, 250);
+    this->positions.append(glm::vec2(70, 70));
+    this->positions.append(glm::vec2(430, 70));
+    this->positions.append(glm::vec2(430, 430));
+    this->positions.append(glm::vec2(70, 430));
+
+    this->tWidth = 20;
+    this->wallInset = 10;
+    this->nodeOffset = 5;
+    this->wallOffset = 40;
+}
+
+std::vector<float> StrategyParams::geometry() const {
+    return {this->tWidth, this->wallInset, this->nodeOffset, this->wallOffset};
+}
+
+QStringList StrategyParams::names() {
+    QStringList result;
+    result << "smoothing" << "start_heat_seeking" << "mosquitoes_to_leave" << "frog_x" << "frog_y" << "corner_inset"
+           << "t_width" << "wall_inset" << "node_offset" << "wall_offset";
+    return result;
+}
+
+float StrategyParams::get(const QString& name) const {
+    if (name == "smoothing") return this->smoothing;
+    if (name == "start_heat_seeking") return this->startHeatSeeking;
+    if (name == "mosquitoes_to_leave") return this->mosquitoesToLeave;
+    if (name == "frog_x") return this->frogPosition.x;
+    if (name == "frog_y") return this->frogPosition.y;
+    if (name == "corner_inset") return this->positions.at(0).x;
+    if (name == "t_width") return this->tWidth;
+    if (name == "wall_inset") return this->wallInset;
+    if (name == "node_offset") return this->nodeOffset;
+    if (name == "wall_offset") return this->wallOffset;
+    return 0.0f;
+}
+
+bool StrategyParams::set(const QString& name, float value) {
+    if (name == "smoothing") this->smoothing = value;
+    else if (name == "start_heat_seeking") this->startHeatSeeking = (int) value;
+    else if (name == "mosquitoes_to_leave") this->mosquitoesToLeave = (int) value;
+    else if (name == "frog_x") this->frogPosition.x = value;
+    else if (name == "frog_y") this->frogPosition.y = value;
+    else if (name == "corner_inset") {
+        float far = PARAMS_BOARD_SIZE - value;
+        this->positions.clear();
+        this->positions.append(glm::vec2(value, value));
+        this->positions.append(glm::vec2(far, value));
+        this->positions.append(glm::vec2(far, far));
+        this->positions.append(glm::vec2(value, far));
+    }
+    else if (name == "t_width") this->tWidth = value;
+    else if (name == "wall_inset") this->wallInset = value;
+    else if (name == "node_offset") this->nodeOffset = value;
+    else if (name == "wall_offset") this->wallOffset = value;
+    else return false;
+    return true;
+}
+
+bool StrategyParams::parse(const QString& assignments) {
+    QStringList parts = assignments.split(",");
+    for (int i = 0; i < parts.size(); i++) {
+        QStringList pair = parts.at(i).split("=");
+        if (pair.size() != 2 || !set(pair.at(0).trimmed(), pair.at(1).trimmed().toFloat())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString StrategyParams::toString() const {
+    QString result;
+    QStringList all = names();
+    for (int i = 0; i < all.size(); i++) {
+        result += (i > 0 ? "," : "") + all.at(i) + "=" + QString::number(get(all.at(i)));
+    }
+    return result;
+}
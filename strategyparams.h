@@ -0,0 +1,39 @@
+#ifndef STRATEGYPARAMS_H
+#define STRATEGYPARAMS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+#include <include/glm/glm.hpp>
+
+// The constants of MyPlayer's strategy and of the wall geometry it plans around. The defaults are the
+// hand-tuned values; the Tuner searches for better ones and --params sets them from the command line.
+struct StrategyParams
+{
+    StrategyParams();
+
+    // MyPlayer
+    float smoothing; // how slowly the lights turn while there are many mosquitoes left to catch
+    int startHeatSeeking; // round from which the lights chase mosquito clusters instead of sweeping the corners
+    int mosquitoesToLeave; // once fewer free mosquitoes than this are left, the lights bring the rest to the frog
+    glm::vec2 frogPosition;
+    QVector<glm::vec2> positions; // where the lights start and sweep between
+
+    // wall geometry (see matrix.cpp)
+    float tWidth; // half the width of the T-walls put across the ends of every wall
+    float wallInset; // how far the T-walls are moved in from the wall's ends
+    float nodeOffset; // how far past a wall's ends the path graph's nodes are
+    float wallOffset; // how far the extended walls stick out past the wall's ends
+
+    std::vector<float> geometry() const; // the values that derived walls and the path graph depend on
+
+    // by name, for the tuner and the command line; corner_inset moves the four positions symmetrically
+    static QStringList names();
+    float get(const QString& name) const;
+    bool set(const QString& name, float value);
+    bool parse(const QString& assignments); // "name=value,name=value"; false if a name is unknown
+    QString toString() const; // in the form parse() reads
+};
+
+#endif // STRATEGYPARAMS_H
@@ -0,0 +1,195 @@
+#include "taskpool.h"
+#include "allocprofile.h"
+
+// the pool and queue of the worker running on this thread (none on other threads)
+static thread_local TaskPool* currentPool = 0;
+static thread_local int currentQueue = -1;
+
+TaskPool::TaskPool(int numThreads)
+    : queued(0), nextQueue(0), stopping(false)
+{
+    if (numThreads < 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    for (int q = 0; q < numThreads; q++) {
+        this->queues.push_back(new Queue());
+    }
+    for (int t = 0; t < numThreads; t++) {
+        this->threads.push_back(std::thread(&TaskPool::work, this, t));
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+    this->wakeUp.notify_all();
+    for (size_t t = 0; t < this->threads.size(); t++) {
+        this->threads[t].join();
+    }
+    for (size_t q = 0; q < this->queues.size(); q++) {
+        delete this->queues[q];
+    }
+}
+
+TaskPool* TaskPool::shared() {
+    static TaskPool pool;
+    return &pool;
+}
+
+int TaskPool::numThreads() {
+    return this->threads.size();
+}
+
+void TaskPool::push(Task task) {
+    int q = currentPool == this ? currentQueue : this->nextQueue++ % this->queues.size();
+    {
+        std::lock_guard<std::mutex> lock(this->queues[q]->mutex);
+        this->queues[q]->tasks.push_back(task);
+    }
+    this->queued++;
+    {
+        // taking the lock makes sure a thread that just found nothing to do is already waiting
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+    this->wakeUp.notify_one();
+}
+
+bool TaskPool::runOne() {
+    int numQueues = this->queues.size();
+    int own = currentPool == this ? currentQueue : -1;
+    Task task;
+    bool found = false;
+    if (own >= 0) {
+        std::lock_guard<std::mutex> lock(this->queues[own]->mutex);
+        if (!this->queues[own]->tasks.empty()) {
+            task = this->queues[own]->tasks.back();
+            this->queues[own]->tasks.pop_back();
+            found = true;
+        }
+    }
+    for (int i = 0; !found && i < numQueues; i++) {
+        Queue* victim = this->queues[(own + 1 + i) % numQueues];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->tasks.empty()) {
+            task = victim->tasks.front();
+            victim->tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    this->queued--;
+
+    // an exception goes to the group's waiter; letting it out would end a worker or skip the count below
+    try {
+        task.run();
+    } catch (...) {
+        task.group->fail(std::current_exception());
+    }
+    if (--task.group->remaining == 0) {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->wakeUp.notify_all();
+    }
+    return true;
+}
+
+void TaskPool::work(int index) {
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wakeUp.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+        if (this->stopping && this->queued == 0) {
+            return;
+        }
+    }
+}
+
+void TaskPool::parallelFor(int count, const std::function<void(int)>& body) {
+    if (count <= 1 || this->queues.empty()) {
+        for (int i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+    // the calling thread does the first item itself and then helps with the rest
+    Group group(this);
+    for (int i = 1; i < count; i++) {
+        group.run([&body, i]() { body(i); });
+    }
+    try {
+        body(0);
+    } catch (...) {
+        group.fail(std::current_exception());
+    }
+    group.wait();
+}
+
+TaskPool::Group::Group(TaskPool* pool)
+    : pool(pool), remaining(0)
+{
+}
+
+TaskPool::Group::~Group() {
+    finish();
+}
+
+void TaskPool::Group::run(std::function<void()> task) {
+    if (this->pool->queues.empty()) {
+        task(); // a pool without workers runs everything on the calling thread
+        return;
+    }
+    this->remaining++;
+    Task t;
+#ifdef ALLOC_PROFILE
+    // the task's allocations count towards the scope that started it, not whatever the worker was doing
+    int phase = AllocProfiler::activePhase();
+    t.run = [task, phase]() {
+        AllocScope scope(phase);
+        task();
+    };
+#else
+    t.run = task;
+#endif
+    t.group = this;
+    this->pool->push(t);
+}
+
+bool TaskPool::Group::isDone() {
+    return this->remaining == 0;
+}
+
+void TaskPool::Group::wait() {
+    finish();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(this->errorMutex);
+        std::swap(error, this->error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskPool::Group::finish() {
+    while (this->remaining > 0) {
+        if (this->pool->runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->pool->sleepMutex);
+        this->pool->wakeUp.wait(lock, [this]() { return this->remaining == 0 || this->pool->queued > 0; });
+    }
+}
+
+void TaskPool::Group::fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(this->errorMutex);
+    if (!this->error) {
+        this->error = error;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing thread pool. Every worker has its own queue: tasks started from a worker go to
+// the back of its queue and it takes its own work from the back, while idle workers steal from the front of
+// the others' queues. Threads waiting for a Group run queued tasks instead of blocking, so tasks can start
+// and wait for tasks of their own (a light planned inside a pipelined Player decision, say).
+// The Board and the players share TaskPool::shared(), so nothing spawns threads per step.
+class TaskPool
+{
+public:
+    TaskPool(int numThreads = -1); // -1: one worker per core
+    ~TaskPool();
+
+    static TaskPool* shared();
+    int numThreads();
+
+    // a set of tasks that can be waited for together
+    class Group
+    {
+    public:
+        Group(TaskPool* pool = TaskPool::shared());
+        ~Group(); // waits for the tasks
+
+        void run(std::function<void()> task);
+        // helps with queued tasks until every task of this group has finished, then rethrows the first
+        // exception one of them threw (a task that throws doesn't stop the others)
+        void wait();
+        bool isDone();
+
+    private:
+        TaskPool* pool;
+        std::atomic<int> remaining;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        void finish(); // wait() without the rethrow, for the destructor
+        void fail(std::exception_ptr error); // keeps the first error
+
+        friend class TaskPool;
+    };
+
+    // calls body(i) for every i in [0, count) in parallel and returns when all have finished; if any of
+    // them threw, the first exception is rethrown then
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+private:
+    struct Task {
+        std::function<void()> run;
+        Group* group;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<Queue*> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued; // tasks in all queues
+    std::atomic<unsigned int> nextQueue; // where tasks from outside the pool go, round robin
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp; // a task was queued, a group finished or the pool is stopping
+    bool stopping;
+
+    void push(Task task);
+    bool runOne(); // runs one queued task on the calling thread; false if there was none
+    void work(int index);
+};
+
+#endif // TASKPOOL_H
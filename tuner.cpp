@@ -0,0 +1,159 @@
+#include "tuner.h"
+#include "board.h"
+#include "myplayer.h"
+#include "scene.h"
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <math.h>
+
+// Plays one headless game with a configuration and stores its rounds-to-target
+class TuningGame : public QRunnable
+{
+public:
+    TuningGame(Tuner* tuner, const StrategyParams& params, Scene* scene, unsigned int seed, int* rounds)
+    {
+        this->tuner = tuner;
+        this->params = params;
+        this->scene = scene;
+        this->seed = seed;
+        this->rounds = rounds;
+    }
+
+    void run() {
+        MyPlayer* player = new MyPlayer();
+        player->params = this->params;
+        player->usePlanner = this->tuner->usePlanner;
+        Board board(player);
+        board.maxRounds = this->tuner->maxRounds;
+        board.setScene(this->scene);
+        board.seed(this->seed);
+        board.initialize();
+        while (!board.finished()) {
+            board.step();
+        }
+        *this->rounds = board.mosquitoesEaten >= board.captureTarget ? board.currRound : board.maxRounds;
+    }
+
+private:
+    Tuner* tuner;
+    StrategyParams params;
+    Scene* scene;
+    unsigned int seed;
+    int* rounds;
+};
+
+double Tuner::Result::mean() {
+    double sum = 0.0;
+    for (int i = 0; i < this->rounds.size(); i++) {
+        sum += this->rounds.at(i);
+    }
+    return this->rounds.isEmpty() ? 0.0 : sum / this->rounds.size();
+}
+
+double Tuner::Result::halfWidth() {
+    int n = this->rounds.size();
+    if (n < 2) {
+        return 0.0;
+    }
+    double m = mean();
+    double sumSquares = 0.0;
+    for (int i = 0; i < n; i++) {
+        sumSquares += (this->rounds.at(i) - m) * (this->rounds.at(i) - m);
+    }
+    return 1.96 * sqrt(sumSquares / (n - 1)) / sqrt((double) n);
+}
+
+Tuner::Tuner()
+{
+    this->numConfigs = 27;
+    this->initialGames = 2;
+    this->eta = 3;
+    this->maxRounds = 5000;
+    this->usePlanner = false;
+    this->layoutPath = "wall_setup.txt";
+    this->seed = 1;
+    this->pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    Range defaults[] = {{"smoothing", 1, 40}, {"start_heat_seeking", 0, 1000}, {"mosquitoes_to_leave", 0, 200},
+                        {"corner_inset", 30, 150}, {"t_width", 5, 40}, {"wall_inset", 0, 30},
+                        {"node_offset", 1, 30}, {"wall_offset", 10, 80}};
+    for (const Range& range : defaults) {
+        this->ranges.append(range);
+    }
+}
+
+StrategyParams Tuner::sample() {
+    StrategyParams params;
+    for (int r = 0; r < this->ranges.size(); r++) {
+        std::uniform_real_distribution<float> value(this->ranges.at(r).low, this->ranges.at(r).high);
+        params.set(this->ranges.at(r).name, value(this->random));
+    }
+    return params;
+}
+
+bool Tuner::playGames(QList<Result*> configs, int games) {
+    // every configuration has its own wall geometry, so it needs its own scene
+    int boardSize = Board(0).boardSize;
+    QList<Scene*> scenes;
+    bool loaded = true;
+    for (int c = 0; c < configs.size(); c++) {
+        Scene* scene = new Scene();
+        loaded = loaded && scene->load(this->layoutPath, boardSize, configs.at(c)->params);
+        scenes.append(scene);
+    }
+    if (loaded) {
+        for (int c = 0; c < configs.size(); c++) {
+            Result* config = configs.at(c);
+            int played = config->rounds.size();
+            config->rounds.resize(games);
+            for (int g = played; g < games; g++) {
+                this->pool.start(new TuningGame(this, config->params, scenes.at(c), this->seed + g, &config->rounds[g]));
+            }
+        }
+        this->pool.waitForDone();
+    }
+    for (int c = 0; c < scenes.size(); c++) {
+        delete scenes.at(c);
+    }
+    return loaded;
+}
+
+StrategyParams Tuner::run(FILE* log) {
+    this->random.seed(this->seed);
+    QList<Result*> alive;
+    for (int c = 0; c < this->numConfigs; c++) {
+        Result* config = new Result();
+        // the first configuration is the current defaults, so the samples have to beat them
+        config->params = c == 0 ? StrategyParams() : sample();
+        alive.append(config);
+    }
+
+    StrategyParams best;
+    int games = this->initialGames;
+    while (!alive.isEmpty()) {
+        if (!playGames(alive, games)) {
+            fprintf(log, "Could not load %s\n", qPrintable(this->layoutPath));
+            break;
+        }
+        std::sort(alive.begin(), alive.end(), [](Result* a, Result* b) { return a->mean() < b->mean(); });
+        fprintf(log, "%d configuration(s) after %d game(s) each:\n", alive.size(), games);
+        for (int c = 0; c < alive.size(); c++) {
+            fprintf(log, "  %.1f +- %.1f rounds: %s\n", alive.at(c)->mean(), alive.at(c)->halfWidth(),
+                    qPrintable(alive.at(c)->params.toString()));
+        }
+        best = alive.first()->params;
+        if (alive.size() == 1) {
+            break;
+        }
+
+        // abandon all but the best 1/eta and give the rest more games
+        int keep = glm::max(1, alive.size() / this->eta);
+        while (alive.size() > keep) {
+            delete alive.takeLast();
+        }
+        games *= this->eta;
+    }
+    qDeleteAll(alive);
+    return best;
+}
@@ -0,0 +1,53 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QThreadPool>
+#include <random>
+#include <stdio.h>
+#include "strategyparams.h"
+
+// Searches MyPlayer's StrategyParams with successive halving: numConfigs random configurations (plus the
+// defaults) play a few headless games each, the best 1/eta of them play eta times as many games, and so
+// on until one is left. Games run in parallel, and game g uses the same seed for every configuration.
+class Tuner
+{
+public:
+    Tuner();
+
+    struct Range {
+        QString name; // a StrategyParams name
+        float low;
+        float high;
+    };
+    QList<Range> ranges; // the parameters that are searched; the others keep their defaults
+
+    int numConfigs;
+    int initialGames; // games every configuration plays in the first round
+    int eta; // each round keeps 1/eta of the configurations and multiplies their games by eta
+    int maxRounds; // rounds per game; a game that doesn't reach the capture target counts as maxRounds
+    bool usePlanner; // tune with MyPlayer's rollout planner on (much slower)
+    QString layoutPath;
+    unsigned int seed;
+
+    // runs the search, reporting progress to log, and returns the best configuration
+    StrategyParams run(FILE* log);
+
+    struct Result {
+        StrategyParams params;
+        QVector<int> rounds; // rounds-to-target of every game played so far
+        double mean();
+        double halfWidth(); // of the 95% confidence interval of the mean
+    };
+
+private:
+    QThreadPool pool;
+    std::mt19937 random;
+
+    StrategyParams sample();
+    bool playGames(QList<Result*> configs, int games); // plays each config up to games games
+};
+
+#endif // TUNER_H
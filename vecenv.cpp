@@ -0,0 +1,151 @@
+#include "vecenv.h"
+#include "taskpool.h"
+#include <new>
+#include <string.h>
+#include <math.h>
+
+// Moves the lights by the slice of the batched actions that belongs to its game
+class ActionPlayer : public Player
+{
+public:
+    const float* actions; // [L][2], set by VecEnv::step
+
+    ActionPlayer() {
+        this->actions = 0;
+        this->playerName = "VecEnv";
+    }
+
+    QVector<glm::vec2> updateLights(QVector<QVector<int> >* board) {
+        QVector<glm::vec2> result(this->lights.size());
+        for (int l = 0; l < result.size(); l++) {
+            result[l] = this->actions ? glm::vec2(this->actions[2 * l], this->actions[2 * l + 1]) : glm::vec2(0.0f, 0.0f);
+        }
+        return result;
+    }
+
+    // the lights start evenly spread on a circle around the middle of the board
+    void initializeLights(QVector<QVector<int> >* board) {
+        float middle = (board->size() - 1) / 2.0f;
+        for (int l = 0; l < this->lights.size(); l++) {
+            float angle = 2 * M_PI * l / this->lights.size();
+            this->lights.at(l)->setInitialPosition(middle + 0.6f * middle * cos(angle), middle + 0.6f * middle * sin(angle));
+        }
+    }
+
+    glm::vec2 initializeFrog(QVector<QVector<int> >* board) {
+        float middle = (board->size() - 1) / 2.0f;
+        return glm::vec2(middle, middle);
+    }
+};
+
+VecEnv::VecEnv(int numEnvs, int numLights, int numMosquitoes, Scene* scene, int gridSize)
+{
+    this->numEnvs = numEnvs;
+    this->numLights = numLights;
+    this->gridSize = gridSize;
+    this->maxRounds = 5000;
+    this->scene = scene;
+    this->baseSeed = 0;
+
+    this->boards = static_cast<Board*>(::operator new(numEnvs * sizeof(Board)));
+    for (int i = 0; i < numEnvs; i++) {
+        ActionPlayer* player = new ActionPlayer();
+        this->players.push_back(player);
+        Board* board = new (&this->boards[i]) Board(player);
+        board->numLights = numLights;
+        board->numMosquitoes = numMosquitoes;
+        board->captureTarget = numMosquitoes;
+        // ActionPlayer ignores the Board's observation and observe() counts its own
+        board->observing = false;
+        if (scene) {
+            board->setScene(scene);
+        }
+    }
+
+    this->occupancy.assign(numEnvs * gridSize * gridSize, 0.0f);
+    this->lights.assign(numEnvs * numLights * 2, 0.0f);
+    this->rewards.assign(numEnvs, 0.0f);
+    this->dones.assign(numEnvs, 0);
+    this->gamesPlayed.assign(numEnvs, 0);
+}
+
+VecEnv::~VecEnv() {
+    // the Boards delete their players
+    for (int i = 0; i < this->numEnvs; i++) {
+        this->boards[i].~Board();
+    }
+    ::operator delete(this->boards);
+}
+
+Board* VecEnv::board(int env) {
+    return &this->boards[env];
+}
+
+void VecEnv::seed(unsigned int seed) {
+    this->baseSeed = seed;
+    this->gamesPlayed.assign(this->numEnvs, 0);
+}
+
+void VecEnv::startGame(int env) {
+    Board& board = this->boards[env];
+    board.seed(this->baseSeed + this->gamesPlayed[env] * this->numEnvs + env);
+    board.maxRounds = this->maxRounds;
+    this->players[env]->actions = 0;
+    board.initialize();
+}
+
+void VecEnv::reset() {
+    TaskPool::shared()->parallelFor(this->numEnvs, [this](int env) {
+        startGame(env);
+        this->rewards[env] = 0.0f;
+        this->dones[env] = 0;
+        observe(env);
+    });
+}
+
+void VecEnv::step(const float* actions) {
+    TaskPool::shared()->parallelFor(this->numEnvs, [this, actions](int env) {
+        Board& board = this->boards[env];
+        int eatenBefore = board.mosquitoesEaten;
+        this->players[env]->actions = actions + env * this->numLights * 2;
+        board.step();
+        bool done = board.finished(); // also counts the eaten mosquitoes
+        this->rewards[env] = board.mosquitoesEaten - eatenBefore;
+        this->dones[env] = done;
+        if (done) {
+            this->gamesPlayed[env]++;
+            startGame(env);
+        }
+        observe(env);
+    });
+}
+
+void VecEnv::observe(int env) {
+    Board& board = this->boards[env];
+    // counted straight from the mosquitoes, which is cheaper than going through the full-resolution grid
+    float* grid = &this->occupancy[env * this->gridSize * this->gridSize];
+    memset(grid, 0, this->gridSize * this->gridSize * sizeof(float));
+    float scale = this->gridSize / (board.boardSize + 1.0f);
+    for (int i = 0; i < board.mosquitoes.length(); i++) {
+        glm::vec2 position = board.mosquitoes.at(i)->position;
+        int x = glm::clamp((int) (position.x * scale), 0, this->gridSize - 1);
+        int y = glm::clamp((int) (position.y * scale), 0, this->gridSize - 1);
+        grid[x * this->gridSize + y] += 1.0f;
+    }
+    if (!board.field.isEmpty()) {
+        // in hybrid mode most of the mosquitoes are amounts per board cell
+        int cells = board.field.size();
+        for (int x = 0; x < cells; x++) {
+            float* column = grid + glm::min((int) (x * scale), this->gridSize - 1) * this->gridSize;
+            for (int y = 0; y < cells; y++) {
+                column[glm::min((int) (y * scale), this->gridSize - 1)] += board.field.at(x, y);
+            }
+        }
+    }
+    float* lights = &this->lights[env * this->numLights * 2];
+    for (int l = 0; l < this->numLights && l < board.lights.length(); l++) {
+        glm::vec2 position = board.lights.at(l)->getPosition();
+        lights[2 * l] = position.x;
+        lights[2 * l + 1] = position.y;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef VECENV_H
+#define VECENV_H
+
+#include <vector>
+#include "board.h"
+
+class ActionPlayer;
+
+// N independent games stepped together, for controllers that pick the moves of every light of every game
+// at once (e.g. a policy network evaluated on a batch). The Boards are one array; step() runs them in
+// parallel on the shared TaskPool and writes the results into flat buffers:
+//   occupancy   [N][gridSize][gridSize]  mosquitoes per cell of a gridSize x gridSize grid over the board
+//   lights      [N][L][2]                light positions
+//   rewards     [N]                      mosquitoes eaten during the step
+//   dones       [N]                      the game ended with this step; it has already been reset
+// A finished game is restarted right away, so its observation is the first one of the next game.
+class VecEnv
+{
+public:
+    VecEnv(int numEnvs, int numLights = 4, int numMosquitoes = 500, Scene* scene = 0, int gridSize = 64);
+    ~VecEnv();
+
+    int numEnvs;
+    int numLights;
+    int gridSize;
+    int maxRounds; // per game (applied when games start)
+
+    void seed(unsigned int seed); // game g of env i is seeded with seed + g * numEnvs + i
+    void reset(); // starts a new game everywhere
+    void step(const float* actions); // actions[N][L][2]: how far every light moves
+
+    Board* board(int env);
+
+    std::vector<float> occupancy;
+    std::vector<float> lights;
+    std::vector<float> rewards;
+    std::vector<unsigned char> dones;
+    std::vector<int> gamesPlayed; // finished games per env
+
+private:
+    Board* boards; // numEnvs Boards next to each other
+    std::vector<ActionPlayer*> players;
+    Scene* scene;
+    unsigned int baseSeed;
+
+    void startGame(int env);
+    void observe(int env);
+};
+
+#endif // VECENV_H
@@ -1,8 +1,6 @@
 #include "wall.h"
 #include <include/glm/glm.hpp>
-#include <iostream>
-
-using namespace std;
+#include "log.h"
 
 Wall::Wall(glm::vec2 pos, glm::vec2 pos2)
 {
@@ -36,16 +34,10 @@ bool Wall::isInvalidMove(glm::vec2 start, glm::vec2 end)
     float x4 = this->point2.x;
     float y4 = this->point2.y;
 
-    bool condition = x1 == 250 && y1 == 70 && x2 == 50 && x3 == 55;
+    bool condition = Logger::enabled(LOG_DEBUG) && x1 == 250 && y1 == 70 && x2 == 50 && x3 == 55;
     if (condition) {
-    cout << "x1 " << x1 << std::endl;
-    cout << "y1 " << 500 -y1 << endl;
-    cout << "x2 " << x2 << endl;
-    cout << "y2 " << 500-y2 << endl;
-    cout << "x3 " << x3 << endl;
-    cout << "y3 " << 500-y3 << endl;
-    cout << "x4 " << x4 << endl;
-    cout << "y4 " << 500-y4 << endl << endl;
+        LOG(LOG_DEBUG) << "x1 " << x1 << " y1 " << 500 - y1 << " x2 " << x2 << " y2 " << 500 - y2;
+        LOG(LOG_DEBUG) << "x3 " << x3 << " y3 " << 500 - y3 << " x4 " << x4 << " y4 " << 500 - y4;
     }
     float a1, a2, a3, a4;
     // deal with special cases
@@ -86,13 +78,10 @@ bool Wall::isInvalidMove(glm::vec2 start, glm::vec2 end)
         bool condition1 = (a1 > 0.0) ^ (a2 > 0.0);
         bool condition2 = (a3 > 0.0) ^ (a4 > 0.0);
         if (condition) {
-            cout << "a1 " << a1 << endl;
-            cout << "a2 " << a2 << endl;
-            cout << "a3 " << a3 << endl;
-            cout << "a4 " << a4 << endl;
-            cout << "(a1 > 0.0) ^ (a2 > 0.0)" << condition1 << endl;
-            cout << "(a3 > 0.0) ^ (a4 > 0.0)" << condition2 << endl;
-            cout << "((a1 > 0.0) ^ (a2 > 0.0)) && ((a3 > 0.0) ^ (a4 > 0.0))" << (((a1 > 0.0) ^ (a2 > 0.0)) && ((a3 > 0.0) ^ (a4 > 0.0))) << endl << endl;
+            LOG(LOG_DEBUG) << "a1 " << a1 << " a2 " << a2 << " a3 " << a3 << " a4 " << a4;
+            LOG(LOG_DEBUG) << "(a1 > 0.0) ^ (a2 > 0.0) " << condition1;
+            LOG(LOG_DEBUG) << "(a3 > 0.0) ^ (a4 > 0.0) " << condition2;
+            LOG(LOG_DEBUG) << "((a1 > 0.0) ^ (a2 > 0.0)) && ((a3 > 0.0) ^ (a4 > 0.0)) " << (((a1 > 0.0) ^ (a2 > 0.0)) && ((a3 > 0.0) ^ (a4 > 0.0)));
         }
 
         return ((a1 > 0.0) ^ (a2 > 0.0)) && ((a3 > 0.0) ^ (a4 > 0.0));
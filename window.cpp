@@ -8,8 +8,6 @@
 #include <QSlider>
 #include <QSpinBox>
 #include <QMessageBox>
-#include <QFile>
-#include <QFileInfo>
 
 Window::Window()
 {
@@ -111,55 +109,15 @@ Window::Window()
 }
 
 void Window::setWalls() {
-    this->helper.b->walls.clear();
-    this->helper.b->player->walls.clear();
-
-    QFile file("wall_setup.txt");
-    file.open(QIODevice::ReadOnly);
-
-    if(!file.isOpen()){
+    // the layout is compiled into a binary scene the first time it is seen and mapped from the cache afterwards
+    if (!this->scene.load("wall_setup.txt", this->helper.b->boardSize)) {
         qDebug() << "WARNING: Could not read wall_setup.txt" << endl << "See assignment description for instructions on how to fix this" << endl;
+        this->helper.b->walls.clear();
+        this->helper.b->player->walls.clear();
         this->helper.b->initialize();
         return;
     }
-
-    QTextStream in(&file);
-    int wallsCount = 0;
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QStringList bits = line.split(",");
-        if (bits.size() == 1) {
-            // get number of walls
-            this->helper.b->numWalls = bits.at(0).trimmed().toInt();
-        } else {
-            // get wall endpoints (MUST HAVE 4 in each )
-            if (bits.size() != 4) {
-                qDebug() << "Wall endpoints incorrectly specified";
-                return;
-            } else {
-                if (wallsCount < this->helper.b->numWalls) {
-                    float currVal = bits.at(0).trimmed().toFloat();
-                    float currVal2 = bits.at(1).trimmed().toFloat();
-                    float currVal3 = bits.at(2).trimmed().toFloat();
-                    float currVal4 = bits.at(3).trimmed().toFloat();
-                    //qDebug() << currVal << currVal2 << currVal3 << currVal4;
-                    this->helper.b->walls.append(new Wall(glm::vec2(currVal, currVal2), glm::vec2(currVal3, currVal4)));
-                    this->helper.b->player->walls.append(new Wall(glm::vec2(currVal, currVal2), glm::vec2(currVal3, currVal4)));
-                    wallsCount++;
-                }
-            }
-        }
-    }
-
-    if (wallsCount < this->helper.b->numWalls) {
-        qDebug() << "You specified " << this->helper.b->numWalls << " wall(s) but only provided endpoints for " << wallsCount;
-        qDebug() << "Using " << wallsCount << " wall(s)";
-        this->helper.b->numWalls = wallsCount;
-    }
-
-//    for (int i = 0; i < this->helper.b->walls.size(); i++) {
-//        qDebug() << this->helper.b->walls.at(i)->position.x << this->helper.b->walls.at(i)->position.y;
-//    }
+    this->helper.b->setScene(&this->scene);
 }
 
 void Window::stop() {
@@ -203,6 +161,7 @@ void Window::startNewGame() {
     setWalls();
     this->helper.b->initialize();
     //setWalls();
+    this->helper.invalidateTrails();
     this->openGL->repaint();
     updateText();
     this->stepButton->setEnabled(true);
@@ -3,6 +3,7 @@
 
 #include "helper.h"
 #include "glwidget.h"
+#include "scene.h"
 
 #include <QWidget>
 #include <QPushButton>
@@ -29,6 +30,7 @@ private slots:
 
 private:
     Helper helper;
+    Scene scene;
     QTimer* timer;
     QLabel* mosquitoLabel;
     QLabel* roundLabel;